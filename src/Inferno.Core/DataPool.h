@@ -2,78 +2,148 @@
 
 #include <vector>
 #include <functional>
+#include "Types.h"
 
 namespace Inferno {
-    // Contiguous data pool that reuses elements when a condition is met.
-    // todo: skip expired items when iterating
-    template<class TData, class TKey = int>
+    // Stable reference to an element in a DataPool. Becomes invalid when the element is removed.
+    struct PoolHandle {
+        uint32 Index = UINT32_MAX;
+        uint32 Generation = 0;
+
+        bool operator==(const PoolHandle&) const = default;
+        constexpr explicit operator bool() const { return Index != UINT32_MAX; }
+    };
+
+    // Contiguous data pool with O(1) add and remove.
+    // Live elements are kept densely packed for iteration, while handles index into a slot array that
+    // tracks where each element is stored. Removing an element moves the last element into its place.
+    // Elements that fail the alive check are removed by Prune().
+    template<class TData>
     class DataPool {
-        std::vector<TData> _data;
+        struct Slot {
+            uint32 Index = 0; // Position in _data when in use, next free slot otherwise
+            uint32 Generation = 0;
+        };
+
+        static constexpr uint32 NO_FREE_SLOT = UINT32_MAX;
+
+        std::vector<TData> _data; // Live elements
+        std::vector<uint32> _dataSlots; // Slot that owns each element in _data
+        std::vector<Slot> _slots;
+        uint32 _freeSlot = NO_FREE_SLOT; // Head of the free slot list
         std::function<bool(const TData&)> _aliveFn;
-        size_t _liveItems = 0;
 
     public:
         DataPool(std::function<bool(const TData&)> aliveFn, size_t capacity)
             : _aliveFn(aliveFn) {
             _data.reserve(capacity);
+            _dataSlots.reserve(capacity);
+            _slots.reserve(capacity);
         }
 
-        TData& Get(TKey key) {
-            assert(InRange(key));
-            return _data[(int64)key];
+        // Returns the element for a handle. Null if the element was removed.
+        TData* Get(PoolHandle handle) {
+            if (!IsValid(handle)) return nullptr;
+            return &_data[_slots[handle.Index].Index];
         }
 
-        // Adds an element to the container
-        TKey Add(const TData& data) {
-            for (size_t i = 0; i < _data.size(); i++) {
-                if (!_aliveFn(_data[i])) {
-                    _data[i] = data;
-                    return (TKey)i;
-                }
-            }
+        const TData* Get(PoolHandle handle) const {
+            if (!IsValid(handle)) return nullptr;
+            return &_data[_slots[handle.Index].Index];
+        }
 
-            _liveItems++;
-            _data.push_back(data);
-            return TKey(_data.size() - 1);
+        bool IsValid(PoolHandle handle) const {
+            // Removing an element increments the slot generation, so stale handles won't match
+            return handle.Index < _slots.size() && _slots[handle.Index].Generation == handle.Generation;
         }
 
-        // Allocates an element
-        [[nodiscard]] TData& Alloc() {
-            for (auto& v : _data) {
-                if (_aliveFn(v))
-                    return v;
-            }
+        // Adds an element to the container
+        PoolHandle Add(const TData& data) {
+            auto handle = AllocSlot();
+            _data.push_back(data);
+            return handle;
+        }
 
+        // Allocates a default constructed element
+        [[nodiscard]] TData& Alloc(PoolHandle* handle = nullptr) {
+            auto h = AllocSlot();
+            if (handle) *handle = h;
             return _data.emplace_back();
         }
 
+        // Removes an element. Invalidates references to the last element.
+        bool Remove(PoolHandle handle) {
+            if (!IsValid(handle)) return false;
+            RemoveAt(_slots[handle.Index].Index);
+            return true;
+        }
+
         void Clear() {
             _data.clear();
-            _liveItems = 0;
+            _dataSlots.clear();
+            _slots.clear();
+            _freeSlot = NO_FREE_SLOT;
         }
 
-        // Updates the live item count
+        // Removes elements that are no longer alive. Only visits live elements.
         void Prune() {
-            for (size_t i = 0; i < _data.size(); i++) {
-                if (_aliveFn(_data[i]))
-                    _liveItems = i;
+            for (size_t i = _data.size(); i-- > 0;) {
+                if (!_aliveFn(_data[i]))
+                    RemoveAt(i);
             }
         }
 
-        // Removes gaps in data
-        void Compact() {}
+        // Number of live elements
+        size_t Count() const { return _data.size(); }
 
-        bool InRange(TKey index) const { return index >= (TKey)0 && index < (TKey)_data.size(); }
+        // Returns the live elements. Elements that died since the last Prune() are included.
+        span<TData> GetLiveData() { return _data; }
+        span<const TData> GetLiveData() const { return _data; }
 
-        // return a span of mostly-live data
-        span<const TData> GetLiveData() const {
-            return span<const TData>(_data.begin(), _liveItems);
-        }
-
-        [[nodiscard]] auto at(size_t index) { return _data.at(index); }
         [[nodiscard]] auto begin() { return _data.begin(); }
         [[nodiscard]] auto end() { return _data.end(); }
         [[nodiscard]] const auto begin() const { return _data.begin(); }
         [[nodiscard]] const auto end() const { return _data.end(); }
+
+    private:
+        // Reserves a slot for an element about to be appended to _data
+        PoolHandle AllocSlot() {
+            uint32 index;
+
+            if (_freeSlot != NO_FREE_SLOT) {
+                index = _freeSlot;
+                _freeSlot = _slots[index].Index;
+            }
+            else {
+                index = (uint32)_slots.size();
+                _slots.emplace_back();
+            }
+
+            auto& slot = _slots[index];
+            slot.Index = (uint32)_data.size();
+            _dataSlots.push_back(index);
+            return { index, slot.Generation };
+        }
+
+        void RemoveAt(size_t dataIndex) {
+            auto slotIndex = _dataSlots[dataIndex];
+            auto last = _data.size() - 1;
+
+            if (dataIndex != last) {
+                // Move the last element into the gap
+                _data[dataIndex] = std::move(_data[last]);
+                _dataSlots[dataIndex] = _dataSlots[last];
+                _slots[_dataSlots[dataIndex]].Index = (uint32)dataIndex;
+            }
+
+            _data.pop_back();
+            _dataSlots.pop_back();
+
+            // Invalidate handles and push the slot onto the free list
+            auto& slot = _slots[slotIndex];
+            slot.Generation++;
+            slot.Index = _freeSlot;
+            _freeSlot = slotIndex;
+        }
     };
-}
\ No newline at end of file
+}
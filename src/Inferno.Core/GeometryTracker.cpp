@@ -0,0 +1,55 @@
+#include "pch.h"
+#include <execution>
+#include "GeometryTracker.h"
+
+namespace Inferno {
+    size_t GeometryTracker::Update(Level& level) {
+        auto& vertices = level.Vertices;
+        _dirtyVertices.assign(vertices.size(), false);
+
+        for (size_t i = 0; i < vertices.size(); i++) {
+            // Compare bits so that moving a vertex to an equal position doesn't count as a change
+            if (i >= _vertices.size() || memcmp(&vertices[i], &_vertices[i], sizeof(Vector3)) != 0)
+                _dirtyVertices[i] = true;
+        }
+
+        _dirtySegments.clear();
+
+        for (int id = 0; id < level.Segments.size(); id++) {
+            auto& seg = level.Segments[id];
+            bool dirty = id >= _indices.size() || seg.Indices != _indices[id];
+
+            for (auto& index : seg.Indices) {
+                if (dirty) break;
+                dirty = index < _dirtyVertices.size() && _dirtyVertices[index];
+            }
+
+            if (dirty) _dirtySegments.push_back((SegID)id);
+        }
+
+        auto update = [&level](SegID id) {
+            level.Segments[(int)id].UpdateGeometricProps(level);
+        };
+
+        if (_dirtySegments.size() >= PARALLEL_THRESHOLD)
+            std::for_each(std::execution::par, _dirtySegments.begin(), _dirtySegments.end(), update);
+        else
+            std::for_each(_dirtySegments.begin(), _dirtySegments.end(), update);
+
+        Capture(level);
+        return _dirtySegments.size();
+    }
+
+    void GeometryTracker::Capture(const Level& level) {
+        _vertices = level.Vertices;
+        _indices.resize(level.Segments.size());
+
+        for (size_t i = 0; i < level.Segments.size(); i++)
+            _indices[i] = level.Segments[i].Indices;
+    }
+
+    void GeometryTracker::Reset() {
+        _vertices.clear();
+        _indices.clear();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Level.h"
+
+namespace Inferno {
+    // Tracks the vertices and segment indices the geometric props were last computed from,
+    // so only segments that reference a moved vertex or were changed need to be recomputed.
+    class GeometryTracker {
+        List<Vector3> _vertices;
+        List<Array<PointID, MAX_VERTICES>> _indices;
+        List<bool> _dirtyVertices; // Scratch space
+        List<SegID> _dirtySegments;
+
+    public:
+        // Segments to update before switching to a parallel loop
+        static constexpr size_t PARALLEL_THRESHOLD = 512;
+
+        // Recomputes the normals, centers and split types of segments that changed since the last update.
+        // Returns the number of segments that were updated.
+        size_t Update(Level& level);
+
+        // Records the current geometry without updating it. Use when the props are known to be up to date.
+        void Capture(const Level& level);
+
+        // Forgets the recorded geometry, so the next update refreshes every segment
+        void Reset();
+    };
+}
\ No newline at end of file
@@ -381,6 +381,36 @@ namespace Inferno {
         }
     }
 
+    void UpdateClipLookups(HamFile& ham) {
+        auto& wallClips = ham.WallClipLookup;
+        wallClips.assign(ham.TexInfo.size(), WClipID::None);
+
+        // Iterate in reverse so the first clip using a texture takes priority
+        for (int i = (int)ham.WallClips.size() - 1; i >= 0; i--) {
+            auto id = (int)ham.WallClips[i].Frames[0];
+            if (id < 0) continue;
+
+            if (id >= (int)wallClips.size())
+                wallClips.resize((size_t)id + 1, WClipID::None);
+
+            wallClips[id] = WClipID(i);
+        }
+
+        auto& effects = ham.EffectClipLookup;
+        effects.assign(ham.LevelTexIdx.size(), EClipID::None);
+
+        for (int i = (int)ham.Effects.size() - 1; i >= 0; i--) {
+            auto id = (int)ham.Effects[i].VClip.Frames[0];
+            if (id < 0) continue;
+
+            // Object effects can use textures that aren't level textures
+            if (id >= (int)effects.size())
+                effects.resize((size_t)id + 1, EClipID::None);
+
+            effects[id] = EClipID(i);
+        }
+    }
+
     HamFile ReadHam(StreamReader& reader) {
         HamFile ham;
 
@@ -474,6 +504,7 @@ namespace Inferno {
         for (auto& r : ham.Reactors) r = ReadReactor(reader);
 
         ham.MarkerModel = (ModelID)reader.ReadInt32();
+        UpdateClipLookups(ham);
         return ham;
     }
 
@@ -511,6 +542,8 @@ namespace Inferno {
         auto bitmapPointers = reader.ReadElementCount();
         for (size_t i = 502; i < 502 + bitmapPointers; i++)
             ham.ObjectBitmapPointers[i] = reader.ReadInt16();
+
+        UpdateClipLookups(ham);
     }
 
     void CheckRange(auto&& xs, auto index, const char* message) {
@@ -567,6 +600,8 @@ namespace Inferno {
             CheckRange(ham.ObjectBitmapPointers, idx, "HXM model object bitmap pointer index out of range");
             ham.ObjectBitmapPointers[idx] = reader.ReadUInt16();
         }
+
+        UpdateClipLookups(ham);
     }
 
     WallClip ReadWallClipD1(StreamReader& r) {
@@ -786,6 +821,7 @@ namespace Inferno {
         }
 
         sounds.DataStart = pig.DataStart = reader.Position();
+        UpdateClipLookups(ham);
         return std::make_tuple(std::move(ham), std::move(pig), std::move(sounds));
     }
 }
\ No newline at end of file
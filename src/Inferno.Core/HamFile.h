@@ -89,6 +89,10 @@ namespace Inferno {
         ModelID ExitModel = ModelID::None; // For D1 exits
         ModelID DestroyedExitModel = ModelID::None; // For D1 exits
 
+        // Reverse lookups for clips. Rebuilt by UpdateClipLookups().
+        List<WClipID> WallClipLookup; // Maps level texture ids to the wall clip starting with that texture
+        List<EClipID> EffectClipLookup; // Maps global texture ids to the effect clip starting with that texture
+
         HamFile() = default;
         ~HamFile() = default;
         HamFile(const HamFile&) = delete;
@@ -101,6 +105,8 @@ namespace Inferno {
     // Read a vertigo ham data and append it
     void AppendVHam(StreamReader&, HamFile&);
     void ReadHXM(StreamReader&, HamFile&);
+    // Rebuilds the reverse clip lookups. Call after modifying textures, wall clips or effects.
+    void UpdateClipLookups(HamFile&);
     VClip ReadVClip(StreamReader&);
     EffectClip ReadEffect(StreamReader&);
     JointPos ReadRobotJoint(StreamReader&);
@@ -1,23 +1,19 @@
 #pragma once
 
+#include <fstream>
+#include <mutex>
 #include "Types.h"
 #include "Streams.h"
 
 // Descent 3 HOG2 file
 namespace Inferno {
-    struct Hog2Entry {
-        string name;
-        uint flags;
-        uint len;
-        uint timestamp;
-        int64 offset;
-    };
-
     class Hog2 {
         static constexpr int PSFILENAME_LEN = 35;
         static constexpr int HOG_HDR_SIZE = 64;
 
         Dictionary<string, int> _lookup;
+        Ptr<std::ifstream> _stream; // Kept open so reads don't reopen the file
+        Ptr<std::mutex> _streamLock = MakePtr<std::mutex>();
     public:
         filesystem::path Path;
 
@@ -33,6 +29,7 @@ namespace Inferno {
             Hog2 hog;
             hog.Path = path;
 
+            auto fileSize = filesystem::file_size(path);
             StreamReader r(path);
             auto id = r.ReadString(4);
             if (id != "HOG2")
@@ -40,11 +37,17 @@ namespace Inferno {
 
             uint nfiles = r.ReadUInt32();
             long file_data_offset = r.ReadUInt32();
+            if (r.Failed())
+                throw Exception("Unexpected end of HOG2 header");
+
+            constexpr uint64 ENTRY_SIZE = PSFILENAME_LEN + 1 + 12;
+            if (4 + HOG_HDR_SIZE + nfiles * ENTRY_SIZE > fileSize)
+                throw Exception("HOG2 file table is past the end of the file");
 
             hog.Entries.reserve(nfiles);
 
             r.Seek(4 + HOG_HDR_SIZE);
-            long offset = file_data_offset;
+            int64 offset = file_data_offset;
             for (uint i = 0; i < nfiles; i++) {
                 auto& entry = hog.Entries.emplace_back();
                 entry.name = String::ToLower(r.ReadString(PSFILENAME_LEN + 1));
@@ -54,32 +57,55 @@ namespace Inferno {
                 entry.offset = offset;
                 offset += entry.len;
 
+                if (r.Failed())
+                    throw Exception("Unexpected end of HOG2 file table");
+
+                if (uint64(offset) > fileSize)
+                    throw Exception(fmt::format("HOG2 entry {} is past the end of the file", entry.name));
+
                 hog._lookup.insert({ entry.name, i });
             }
 
+            hog._stream = MakePtr<std::ifstream>(path, std::ios::binary);
             return hog;
         }
 
         List<Entry> Entries;
 
+        // Returns the index of an entry, or -1 if not found. Names are case insensitive.
+        int Find(const string& name) const {
+            auto index = _lookup.find(String::ToLower(name));
+            return index == _lookup.end() ? -1 : index->second;
+        }
+
+        // Thread safe
         List<ubyte> ReadEntry(int index) {
             if (!Seq::inRange(Entries, index))
                 throw Exception("Invalid entry index");
 
-            StreamReader r(Path);
             const auto& entry = Entries[index];
-            r.Seek(entry.offset);
             List<ubyte> data(entry.len);
-            r.ReadBytes(data);
+
+            std::scoped_lock lock(*_streamLock);
+            if (!_stream || !_stream->is_open())
+                throw Exception("HOG2 file is not open");
+
+            _stream->clear(); // Reset EOF from any previous read
+            _stream->seekg(entry.offset);
+            _stream->read((char*)data.data(), data.size());
+
+            if (_stream->gcount() != (std::streamsize)data.size())
+                throw Exception(fmt::format("Unable to read HOG2 entry {}", entry.name));
+
             return data;
         }
 
-        Option<List<ubyte>> ReadEntry(string name) {
-            name = String::ToLower(name);
-            if (!_lookup.contains(name))
+        Option<List<ubyte>> ReadEntry(const string& name) {
+            auto index = Find(name);
+            if (index == -1)
                 return {};
-            
-            return ReadEntry(_lookup[name]);
+
+            return ReadEntry(index);
         }
     };
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "pch.h"
 #include "OutrageBitmap.h"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace Inferno::Outrage {
     enum ImageType {
         OUTRAGE_4444_COMPRESSED_MIPPED = 121, // Only used for textures with specular data
@@ -25,35 +29,93 @@ namespace Inferno::Outrage {
         BITMAP_FORMAT_4444 = 1,
     };
 
-    constexpr int Conv5to8(int n) { return (n << 3) | (n >> 2); }
-
-    List<uint> Decompress(span<ushort> data, int width, int height, ImageType type) {
-        List<uint> img(width * height);
-        const int lastrow = (width - 1) * height;
-
-        for (int ofs = 0; ofs <= lastrow; ofs += width) {
-            if (type == OUTRAGE_4444_COMPRESSED_MIPPED) {
-                for (int x = 0; x < width; x++) {
-                    const ushort n = data[ofs + x];
-                    //const int a = ((n >> 12) & 0x0f) * 0x11;
-                    constexpr int a = 0xff; // ignore alpha for now. it should be extracted as a specular mask
-                    const int r = ((n >> 8) & 0x0f) * 0x11;
-                    const int g = ((n >> 4) & 0x0f) * 0x11;
-                    const int b = (n & 0x0f) * 0x11;
-                    img[ofs + x] = a << 24 | b << 16 | g << 8 | r;
-                }
-            }
-            else {
-                for (int x = 0; x < width; x++) {
-                    const ushort n = data[ofs + x];
-                    img[ofs + x] =
-                        ((n & 0x8000) * 0x1fe00) |
-                        (Conv5to8((n & 0x7c00) >> 10) << 0) |
-                        (Conv5to8((n & 0x03e0) >> 5) << 8) |
-                        (Conv5to8((n & 0x001f) >> 0) << 16);
-                }
-            }
+    constexpr uint Conv5to8(uint n) { return (n << 3) | (n >> 2); }
+    constexpr uint Conv4to8(uint n) { return n * 0x11; }
+
+    // Converts 1555 pixels to RGBA8
+    void Decode1555(span<const ushort> src, span<uint> dest) {
+        size_t i = 0;
+
+#if defined(_M_X64) || defined(__SSE2__)
+        const auto mask5 = _mm_set1_epi32(0x1f);
+        const auto alphaMask = _mm_set1_epi32((int)0xff000000);
+
+        auto expand = [&](__m128i n) {
+            auto r = _mm_and_si128(_mm_srli_epi32(n, 10), mask5);
+            auto g = _mm_and_si128(_mm_srli_epi32(n, 5), mask5);
+            auto b = _mm_and_si128(n, mask5);
+            r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+            g = _mm_or_si128(_mm_slli_epi32(g, 3), _mm_srli_epi32(g, 2));
+            b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+
+            // Shift the alpha bit into the sign bit and smear it across the lane
+            auto a = _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(n, 16), 31), alphaMask);
+            return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), a));
+        };
+
+        // Eight pixels at a time
+        for (; i + 8 <= src.size(); i += 8) {
+            auto n = _mm_loadu_si128((const __m128i*)&src[i]);
+            auto zero = _mm_setzero_si128();
+            _mm_storeu_si128((__m128i*)&dest[i], expand(_mm_unpacklo_epi16(n, zero)));
+            _mm_storeu_si128((__m128i*)&dest[i + 4], expand(_mm_unpackhi_epi16(n, zero)));
+        }
+#endif
+
+        for (; i < src.size(); i++) {
+            const uint n = src[i];
+            dest[i] =
+                ((n & 0x8000) * 0x1fe00) |
+                (Conv5to8((n & 0x7c00) >> 10) << 0) |
+                (Conv5to8((n & 0x03e0) >> 5) << 8) |
+                (Conv5to8((n & 0x001f) >> 0) << 16);
         }
+    }
+
+    // Converts 4444 pixels to RGBA8. Alpha is ignored for now, it should be extracted as a specular mask.
+    void Decode4444(span<const ushort> src, span<uint> dest) {
+        size_t i = 0;
+
+#if defined(_M_X64) || defined(__SSE2__)
+        const auto mask4 = _mm_set1_epi32(0x0f);
+        const auto alpha = _mm_set1_epi32((int)0xff000000);
+
+        auto expand = [&](__m128i n) {
+            auto r = _mm_and_si128(_mm_srli_epi32(n, 8), mask4);
+            auto g = _mm_and_si128(_mm_srli_epi32(n, 4), mask4);
+            auto b = _mm_and_si128(n, mask4);
+            r = _mm_or_si128(r, _mm_slli_epi32(r, 4));
+            g = _mm_or_si128(g, _mm_slli_epi32(g, 4));
+            b = _mm_or_si128(b, _mm_slli_epi32(b, 4));
+            return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+        };
+
+        for (; i + 8 <= src.size(); i += 8) {
+            auto n = _mm_loadu_si128((const __m128i*)&src[i]);
+            auto zero = _mm_setzero_si128();
+            _mm_storeu_si128((__m128i*)&dest[i], expand(_mm_unpacklo_epi16(n, zero)));
+            _mm_storeu_si128((__m128i*)&dest[i + 4], expand(_mm_unpackhi_epi16(n, zero)));
+        }
+#endif
+
+        for (; i < src.size(); i++) {
+            const uint n = src[i];
+            //const uint a = Conv4to8((n >> 12) & 0x0f);
+            constexpr uint a = 0xff;
+            const uint r = Conv4to8((n >> 8) & 0x0f);
+            const uint g = Conv4to8((n >> 4) & 0x0f);
+            const uint b = Conv4to8(n & 0x0f);
+            dest[i] = a << 24 | b << 16 | g << 8 | r;
+        }
+    }
+
+    List<uint> Decompress(span<const ushort> data, ImageType type) {
+        List<uint> img(data.size());
+
+        if (type == OUTRAGE_4444_COMPRESSED_MIPPED)
+            Decode4444(data, img);
+        else
+            Decode1555(data, img);
 
         return img;
     }
@@ -120,7 +182,7 @@ namespace Inferno::Outrage {
                 }
             }
 
-            mip = Decompress(data, width, height, (ImageType)ogf.Type);
+            mip = Decompress(data, (ImageType)ogf.Type);
         }
 
         return ogf;
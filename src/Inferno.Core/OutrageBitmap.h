@@ -17,9 +17,9 @@ namespace Inferno::Outrage {
     // Descent 3 VClips are bitmaps with an extra header (OAF)
     struct VClip {
         List<Bitmap> Frames;
-        float FrameTime;
-        int Version;
-        bool PingPong;
+        float FrameTime = 0;
+        int Version = 0;
+        bool PingPong = false;
         string FileName;
 
         static VClip Read(StreamReader& r);
@@ -335,33 +335,123 @@ namespace Inferno::Outrage {
         return gen;
     }
 
-    GameTable GameTable::Read(StreamReader& r) {
+    StreamReader GameTable::OpenPage(const TablePage& page) {
+        StreamReader r(span(_data).subspan(page.Offset, page.Length));
+        r.ReadInt32(); // length
+        return r;
+    }
+
+    const TextureInfo& GameTable::GetTexture(int index) {
+        auto& tex = _textures.at(index);
+        if (!tex) {
+            auto r = OpenPage(_texturePages[index]);
+            tex = ReadTexturePage(r);
+        }
+
+        return *tex;
+    }
+
+    const SoundInfo& GameTable::GetSound(int index) {
+        auto& sound = _sounds.at(index);
+        if (!sound) {
+            auto r = OpenPage(_soundPages[index]);
+            sound = ReadSoundPage(r);
+        }
+
+        return *sound;
+    }
+
+    const GenericInfo& GameTable::GetGeneric(int index) {
+        auto& gen = _generics.at(index);
+        if (!gen) {
+            auto r = OpenPage(_genericPages[index]);
+            gen = ReadGenericPage(r);
+        }
+
+        return *gen;
+    }
+
+    const TextureInfo* GameTable::FindTexture(const string& name) {
+        auto index = _textureLookup.find(String::ToLower(name));
+        return index == _textureLookup.end() ? nullptr : &GetTexture(index->second);
+    }
+
+    const TextureInfo* GameTable::FindTextureByFileName(const string& fileName) {
+        auto index = _textureFileLookup.find(String::ToLower(fileName));
+        return index == _textureFileLookup.end() ? nullptr : &GetTexture(index->second);
+    }
+
+    const SoundInfo* GameTable::FindSound(const string& name) {
+        auto index = _soundLookup.find(String::ToLower(name));
+        return index == _soundLookup.end() ? nullptr : &GetSound(index->second);
+    }
+
+    const GenericInfo* GameTable::FindGeneric(const string& name) {
+        auto index = _genericLookup.find(String::ToLower(name));
+        return index == _genericLookup.end() ? nullptr : &GetGeneric(index->second);
+    }
+
+    GameTable GameTable::Read(List<ubyte>&& data) {
         GameTable table{};
+        table._data = std::move(data);
+
+        // Adds a page to the index. Duplicate names resolve to the first page, same as a linear search.
+        auto addPage = [](TablePage&& page, List<TablePage>& pages, Dictionary<string, int>& lookup) {
+            auto index = (int)pages.size();
+            lookup.try_emplace(String::ToLower(page.Name), index);
+            pages.push_back(std::move(page));
+            return index;
+        };
+
+        size_t position = 0;
+        span<ubyte> buffer = table._data;
+
+        while (position + 5 <= buffer.size()) {
+            auto pageType = buffer[position];
+            auto pageStart = uint32(position + 1);
 
-        while (!r.EndOfStream()) {
-            auto pageType = r.ReadByte();
-            auto pageStart = r.Position();
-            auto len = r.ReadInt32();
+            int32 len;
+            memcpy(&len, &buffer[pageStart], sizeof len);
             if (len <= 0) throw Exception("bad page length");
 
+            TablePage page{ .Offset = pageStart, .Length = (uint32)std::min<size_t>(len, buffer.size() - pageStart) };
+
+            // Only the names are read up front
+            StreamReader r(buffer.subspan(page.Offset, page.Length));
+            r.ReadInt32(); // length
+            r.ReadInt16(); // version
+
             switch (pageType) {
                 case PAGETYPE_TEXTURE:
-                    table.Textures.push_back(ReadTexturePage(r));
+                {
+                    page.Name = r.ReadCString(MAX_STRING_LEN);
+                    page.FileName = r.ReadCString(MAX_STRING_LEN);
+                    auto fileName = String::ToLower(page.FileName);
+                    auto index = addPage(std::move(page), table._texturePages, table._textureLookup);
+                    table._textureFileLookup.try_emplace(fileName, index);
                     break;
+                }
 
                 case PAGETYPE_SOUND:
-                    table.Sounds.push_back(ReadSoundPage(r));
+                    page.Name = r.ReadCString(PAGENAME_LEN);
+                    page.FileName = r.ReadCString(PAGENAME_LEN);
+                    addPage(std::move(page), table._soundPages, table._soundLookup);
                     break;
 
                 case PAGETYPE_GENERIC:
-                    table.Generics.push_back(ReadGenericPage(r));
+                    r.ReadByte(); // type
+                    page.Name = r.ReadCString(PAGENAME_LEN);
+                    page.FileName = r.ReadCString(PAGENAME_LEN);
+                    addPage(std::move(page), table._genericPages, table._genericLookup);
                     break;
             }
 
-            //auto readbytes = r.Position() - pageStart;
-            r.Seek(pageStart + len); // seek to next chunk (prevents read errors due to individual chunks)
+            position = pageStart + len; // seek to next chunk (prevents read errors due to individual chunks)
         }
 
+        table._textures.resize(table._texturePages.size());
+        table._sounds.resize(table._soundPages.size());
+        table._generics.resize(table._genericPages.size());
         return table;
     }
-}
+}
\ No newline at end of file
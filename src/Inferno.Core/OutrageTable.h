@@ -376,18 +376,56 @@ namespace Inferno::Outrage {
         constexpr bool HasFlag(GenericFlag flag) { return (bool)(Flags & flag); }
     };
 
-    struct GameTable {
+    // Location of a page in a table file
+    struct TablePage {
+        uint32 Offset = 0; // Start of the page, including the length
+        uint32 Length = 0;
+        string Name;
+        string FileName; // Bitmap or sound file. Model for generics.
+    };
+
+    // Descent 3 table file. Reading only indexes the pages, which are decoded on first lookup.
+    // Lookups are not thread safe.
+    class GameTable {
+        List<ubyte> _data;
+
+        List<TablePage> _texturePages, _soundPages, _genericPages;
+        List<Option<TextureInfo>> _textures;
+        List<Option<SoundInfo>> _sounds;
+        List<Option<GenericInfo>> _generics;
+
+        // Lowercase name to page index
+        Dictionary<string, int> _textureLookup, _textureFileLookup, _soundLookup, _genericLookup;
+
+    public:
         enum {
             TABLE_FILE_BASE = 0,
             TABLE_FILE_MISSION = 1,
             TABLE_FILE_MODULE = 2
         } Type{};
-        
+
         string Name;
 
-        List<TextureInfo> Textures;
-        List<SoundInfo> Sounds;
-        List<GenericInfo> Generics;
-        static GameTable Read(StreamReader&);
+        // Page names are available without decoding
+        span<const TablePage> GetTexturePages() const { return _texturePages; }
+        span<const TablePage> GetSoundPages() const { return _soundPages; }
+        span<const TablePage> GetGenericPages() const { return _genericPages; }
+
+        const TextureInfo& GetTexture(int index);
+        const SoundInfo& GetSound(int index);
+        const GenericInfo& GetGeneric(int index);
+
+        // Case insensitive lookups. Returns null if not found.
+        const TextureInfo* FindTexture(const string& name);
+        const TextureInfo* FindTextureByFileName(const string& fileName);
+        const SoundInfo* FindSound(const string& name);
+        const GenericInfo* FindGeneric(const string& name);
+
+        // Indexes the pages of a table file in a single pass
+        static GameTable Read(List<ubyte>&& data);
+
+    private:
+        // Returns a reader positioned after the page length
+        StreamReader OpenPage(const TablePage& page);
     };
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "Particles.h"
+
+using namespace DirectX;
+
+namespace Inferno {
+    void ParticleBuffer::Add(const Particle& p) {
+        _x.push_back(p.Position.x);
+        _y.push_back(p.Position.y);
+        _z.push_back(p.Position.z);
+        _vx.push_back(p.Velocity.x);
+        _vy.push_back(p.Velocity.y);
+        _vz.push_back(p.Velocity.z);
+        _rotation.push_back(p.Rotation);
+        _angularVelocity.push_back(p.AngularVelocity);
+        _life.push_back(p.Life);
+        _duration.push_back(p.Life);
+        _radius.push_back(p.Radius);
+        _color.push_back(p.Color);
+        _up.push_back(p.Up);
+        _clip.push_back(p.Clip);
+    }
+
+    void ParticleBuffer::Update(float dt) {
+        auto count = Count();
+        auto dtv = XMVectorReplicate(dt);
+        size_t i = 0;
+
+        // Four particles at a time
+        for (; i + 4 <= count; i += 4) {
+            auto life = XMLoadFloat4((XMFLOAT4*)&_life[i]);
+            XMStoreFloat4((XMFLOAT4*)&_life[i], XMVectorSubtract(life, dtv));
+
+            auto rotation = XMLoadFloat4((XMFLOAT4*)&_rotation[i]);
+            auto angularVelocity = XMLoadFloat4((XMFLOAT4*)&_angularVelocity[i]);
+            XMStoreFloat4((XMFLOAT4*)&_rotation[i], XMVectorMultiplyAdd(angularVelocity, dtv, rotation));
+
+            auto x = XMLoadFloat4((XMFLOAT4*)&_x[i]);
+            auto y = XMLoadFloat4((XMFLOAT4*)&_y[i]);
+            auto z = XMLoadFloat4((XMFLOAT4*)&_z[i]);
+            auto vx = XMLoadFloat4((XMFLOAT4*)&_vx[i]);
+            auto vy = XMLoadFloat4((XMFLOAT4*)&_vy[i]);
+            auto vz = XMLoadFloat4((XMFLOAT4*)&_vz[i]);
+            XMStoreFloat4((XMFLOAT4*)&_x[i], XMVectorMultiplyAdd(vx, dtv, x));
+            XMStoreFloat4((XMFLOAT4*)&_y[i], XMVectorMultiplyAdd(vy, dtv, y));
+            XMStoreFloat4((XMFLOAT4*)&_z[i], XMVectorMultiplyAdd(vz, dtv, z));
+        }
+
+        // Remainder
+        for (; i < count; i++) {
+            _life[i] -= dt;
+            _rotation[i] += _angularVelocity[i] * dt;
+            _x[i] += _vx[i] * dt;
+            _y[i] += _vy[i] * dt;
+            _z[i] += _vz[i] * dt;
+        }
+
+        // Compact by moving live particles from the end into the gaps
+        for (size_t j = count; j-- > 0;) {
+            if (_life[j] <= 0)
+                RemoveAt(j);
+        }
+    }
+
+    void ParticleBuffer::Clear() {
+        _x.clear();
+        _y.clear();
+        _z.clear();
+        _vx.clear();
+        _vy.clear();
+        _vz.clear();
+        _rotation.clear();
+        _angularVelocity.clear();
+        _life.clear();
+        _duration.clear();
+        _radius.clear();
+        _color.clear();
+        _up.clear();
+        _clip.clear();
+    }
+
+    void ParticleBuffer::RemoveAt(size_t i) {
+        auto removeAt = [i](auto& xs) {
+            xs[i] = xs.back();
+            xs.pop_back();
+        };
+
+        removeAt(_x);
+        removeAt(_y);
+        removeAt(_z);
+        removeAt(_vx);
+        removeAt(_vy);
+        removeAt(_vz);
+        removeAt(_rotation);
+        removeAt(_angularVelocity);
+        removeAt(_life);
+        removeAt(_duration);
+        removeAt(_radius);
+        removeAt(_color);
+        removeAt(_up);
+        removeAt(_clip);
+    }
+}
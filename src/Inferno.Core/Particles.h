@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Types.h"
+
+namespace Inferno {
+    struct Particle {
+        VClipID Clip = VClipID::None;
+        Vector3 Position;
+        Vector3 Velocity;
+        Vector3 Up = Vector3::Zero; // Constrains the sprite to this axis when set
+        Color Color = { 1, 1, 1 };
+        float Radius = 1;
+        float Rotation = 0;
+        float AngularVelocity = 0; // Radians per second
+        float Life = 0;
+
+        static bool IsAlive(const Particle& p) { return p.Life > 0; }
+    };
+
+    // Texture and aspect ratio (height / width) of a sprite frame
+    struct SpriteFrame {
+        TexID Texture = TexID::None;
+        float Ratio = 1;
+    };
+
+    // Range of quads in a vertex list that use the same texture
+    struct SpriteBatch {
+        TexID Texture = TexID::None;
+        uint32 Start = 0; // First quad
+        uint32 Count = 0; // Number of quads
+    };
+
+    // Particles stored as a structure of arrays so the update can process several at once.
+    // Has no GPU dependencies.
+    class ParticleBuffer {
+        List<float> _x, _y, _z; // Position
+        List<float> _vx, _vy, _vz; // Velocity
+        List<float> _rotation, _angularVelocity;
+        List<float> _life, _duration;
+        List<float> _radius;
+        List<Color> _color;
+        List<Vector3> _up;
+        List<VClipID> _clip;
+        List<std::pair<TexID, uint32>> _sortKeys; // Scratch space for batching
+
+    public:
+        // Adds a particle. Life is the duration of the particle in seconds.
+        void Add(const Particle& particle);
+
+        // Advances all particles and removes the expired ones
+        void Update(float dt);
+
+        void Clear();
+        size_t Count() const { return _life.size(); }
+
+        // Seconds the particle has been alive
+        float GetElapsed(size_t i) const { return _duration[i] - _life[i]; }
+        Vector3 GetPosition(size_t i) const { return { _x[i], _y[i], _z[i] }; }
+        float GetRotation(size_t i) const { return _rotation[i]; }
+
+        // Builds camera facing quads for every particle, grouped by texture.
+        // getFrame(VClipID, float elapsed) returns the SpriteFrame to draw. Particles with no texture are skipped.
+        // TVertex must be constructible from (Vector3 position, Vector2 uv, Color color).
+        template<class TVertex>
+        void BuildBatches(const Vector3& cameraPosition, const Vector3& cameraUp, auto&& getFrame,
+                          List<TVertex>& vertices, List<SpriteBatch>& batches) {
+            vertices.clear();
+            batches.clear();
+            _sortKeys.clear();
+
+            List<SpriteFrame> frames(Count());
+
+            for (uint32 i = 0; i < Count(); i++) {
+                frames[i] = getFrame(_clip[i], GetElapsed(i));
+                if (frames[i].Texture > TexID::None)
+                    _sortKeys.push_back({ frames[i].Texture, i });
+            }
+
+            // Group by texture so each texture is bound once
+            ranges::sort(_sortKeys);
+            vertices.reserve(_sortKeys.size() * 4);
+
+            for (auto& [texture, i] : _sortKeys) {
+                if (batches.empty() || batches.back().Texture != texture)
+                    batches.push_back({ texture, uint32(vertices.size() / 4), 0 });
+
+                batches.back().Count++;
+
+                auto position = GetPosition(i);
+                auto transform = _up[i] == Vector3::Zero ?
+                    Matrix::CreateBillboard(position, cameraPosition, cameraUp) :
+                    Matrix::CreateConstrainedBillboard(position, cameraPosition, _up[i]);
+
+                if (_rotation[i] != 0)
+                    transform = Matrix::CreateRotationZ(_rotation[i]) * transform;
+
+                auto w = _radius[i];
+                auto h = w * frames[i].Ratio;
+                auto& color = _color[i];
+                vertices.emplace_back(Vector3::Transform({ -w, h, 0 }, transform), Vector2{ 0, 0 }, color); // bl
+                vertices.emplace_back(Vector3::Transform({ w, h, 0 }, transform), Vector2{ 1, 0 }, color); // br
+                vertices.emplace_back(Vector3::Transform({ w, -h, 0 }, transform), Vector2{ 1, 1 }, color); // tr
+                vertices.emplace_back(Vector3::Transform({ -w, -h, 0 }, transform), Vector2{ 0, 1 }, color); // tl
+            }
+        }
+
+    private:
+        // Moves the last particle into index i
+        void RemoveAt(size_t i);
+    };
+}
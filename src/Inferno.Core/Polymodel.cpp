@@ -1,7 +1,6 @@
 #include "pch.h"
 #include <numeric>
 #include "Polymodel.h"
-#include "Streams.h"
 #include "Utility.h"
 
 namespace Inferno {
@@ -19,101 +18,247 @@ namespace Inferno {
         Glow = 8
     };
 
-    // 'Expands' vertices in each submodel to a buffer for each texture
-    void Expand(Model& model, span<Vector3> points) {
-        for (auto& sm : model.Submodels) {
-            // expand submodel vertices from indices for use in buffers
-            // +1 slot is for flat polygons
-            sm.ExpandedIndices.resize(model.TextureCount + 1);
-
-            for (uint16 i = 0; i < sm.Indices.size(); i++) {
-                auto& tmap = sm.TMaps[i / 3]; // textures are stored per face (3 indices per triangle)
-                // store indices by texture.
-                // this creates empty arrays for texture slots that are not used
-                sm.ExpandedIndices[tmap].push_back(i);
-                auto& p = points[sm.Indices[i]];
-                sm.ExpandedPoints.push_back(p);
-                sm.ExpandedColors.push_back({ 1, 1, 1, 1 });
+    // Reads values in place from POF data
+    class PolymodelData {
+        span<const ubyte> _data;
+
+    public:
+        PolymodelData(span<const ubyte> data) : _data(data) {}
+
+        template<class T>
+        T Read(size_t offset) const {
+            if (offset + sizeof(T) > _data.size())
+                throw Exception("Unexpected end of POF data");
+
+            T value;
+            memcpy(&value, _data.data() + offset, sizeof(T));
+            return value;
+        }
+
+        int16 ReadInt16(size_t offset) const { return Read<int16>(offset); }
+
+        Vector3 ReadVector(size_t offset) const {
+            return { FixToFloat(Read<fix>(offset)), FixToFloat(Read<fix>(offset + 4)), FixToFloat(Read<fix>(offset + 8)) };
+        }
+    };
+
+    // Number of points in a polygon chunk
+    int16 ReadPolygonLength(const PolymodelData& data, size_t chunkStart) {
+        auto n = data.ReadInt16(chunkStart + 2);
+        if (n <= 2 || n >= MAX_POINTS_PER_POLY)
+            throw Exception("Polygon must have between 3 and 64 points");
+
+        return n;
+    }
+
+    // Size of the point indices in a polygon chunk, which are padded to an even count
+    constexpr size_t PolygonIndicesSize(int16 n) { return ((n & ~1) + 1) * 2; }
+
+    // Walks the chunks of a submodel in draw order, calling visit(op, chunkStart) for each.
+    // Uses an explicit stack for sort normal and subobject calls.
+    void WalkChunks(const PolymodelData& data, size_t start, auto&& visit) {
+        constexpr size_t MAX_DEPTH = 256;
+        List<size_t> stack;
+        size_t chunkStart = start;
+
+        while (true) {
+            auto op = (OpCode)data.ReadInt16(chunkStart);
+
+            if (op == OpCode::End) {
+                if (stack.empty()) return;
+                chunkStart = stack.back();
+                stack.pop_back();
+                continue;
             }
 
-            auto flatOffset = (uint16)sm.ExpandedPoints.size();
+            if (stack.size() > MAX_DEPTH)
+                throw Exception("POF data is nested too deeply");
+
+            size_t chunkLen = 0;
+
+            switch (op) {
+                case OpCode::DefPoints:
+                    throw NotImplementedException(); // unused
+
+                case OpCode::DefpointStart: // indicates the start of a submodel
+                    if (data.ReadInt16(chunkStart + 6) != 0) throw Exception("Defpoint Start must equal zero");
+                    chunkLen = data.ReadInt16(chunkStart + 2) * 12 /*sizeof(vector)*/ + 8;
+                    break;
 
-            // Append flat indices
-            for (uint16 i = 0; i < sm.FlatIndices.size(); i++) {
-                auto& color = sm.FlatVertexColors[i / 3];
-                auto& p = points[sm.FlatIndices[i]];
-                sm.ExpandedIndices[model.TextureCount].push_back(flatOffset + i);
-                sm.ExpandedPoints.push_back(p);
-                sm.ExpandedColors.push_back(color);
+                case OpCode::FlatPoly:
+                    chunkLen = 30 + PolygonIndicesSize(ReadPolygonLength(data, chunkStart));
+                    break;
+
+                case OpCode::MappedPoly:
+                {
+                    auto n = ReadPolygonLength(data, chunkStart);
+                    chunkLen = 30 + PolygonIndicesSize(n) + n * 12; // n & ~1 skips index 0 and 1
+                    break;
+                }
+
+                case OpCode::SortNormal:
+                    // Draw the back branch, then the front branch, then continue after this chunk
+                    stack.push_back(chunkStart + 32);
+                    stack.push_back(chunkStart + data.ReadInt16(chunkStart + 28));
+                    chunkStart += data.ReadInt16(chunkStart + 30);
+                    continue;
+
+                case OpCode::RodBitmap:
+                    // Unused. Might have been intended for the energy drain robot.
+                    throw NotImplementedException();
+
+                case OpCode::CallSubobject:
+                    visit(op, chunkStart);
+                    stack.push_back(chunkStart + 20);
+                    chunkStart += data.ReadInt16(chunkStart + 16);
+                    continue;
+
+                case OpCode::Glow:
+                    chunkLen = 4;
+                    break;
+
+                default:
+                    throw Exception("Error parsing POF data");
             }
+
+            visit(op, chunkStart);
+            chunkStart += chunkLen;
         }
     }
 
-    void ReadPolymodel(Model& model, span<ubyte> data, Palette* palette) {
-        // 'global' state for the interpreter
-        int16 highestTex = -1;
-        StreamReader reader(data);
+    // Vertices are only shared when they are bitwise identical
+    struct SubmodelVertexHash {
+        size_t operator()(const SubmodelVertex& v) const {
+            return HashBytes(span((const ubyte*)&v, sizeof v));
+        }
+    };
+
+    struct SubmodelVertexEquals {
+        bool operator()(const SubmodelVertex& a, const SubmodelVertex& b) const {
+            return memcmp(&a, &b, sizeof a) == 0;
+        }
+    };
+
+    static_assert(sizeof(SubmodelVertex) == 48, "SubmodelVertex must not contain padding");
+
+    void ReadPolymodel(Model& model, span<ubyte> bytes, Palette* palette) {
+        if (model.Submodels.size() > MAX_SUBMODELS) throw Exception("Model contains too many submodels");
+
+        PolymodelData data(bytes);
+        const int slots = model.TextureCount + 1; // +1 slot is for flat polygons
+
+        // Submodels must be loaded in order of pointer offset.
+        // Doing this allows extracting all mesh data ahead of time instead of per frame.
+        List<int> pointers = Seq::map(model.Submodels, [](const auto& sm) { return sm.Pointer; });
+        List<int16> loadOrder(pointers.size());
+        std::iota(loadOrder.begin(), loadOrder.end(), (int16)0); // fill range 0 .. n
+        Seq::sortBy(loadOrder, [&pointers](auto a, auto b) {
+            return pointers[a] < pointers[b]; // sort load order by pointer offsets
+        });
+
+        // First pass: validate the data, collect the points of every submodel and count the triangles so every list is allocated once.
+        // Points are collected up front because custom models can reference points defined by a later submodel.
+        List<Vector3> points;
+        List<List<uint32>> triangleCounts(model.Submodels.size(), List<uint32>(slots));
+
+        for (auto& i : loadOrder) {
+            auto& counts = triangleCounts[i];
+
+            WalkChunks(data, model.Submodels[i].Pointer, [&](OpCode op, size_t chunkStart) {
+                if (op == OpCode::DefpointStart) {
+                    // Discard the point index. This assumes that vertices are always stored in submodel order
+                    // which holds true for all official models.
+                    auto n = data.ReadInt16(chunkStart + 2);
+                    for (int j = 0; j < n; j++)
+                        points.push_back(data.ReadVector(chunkStart + 8 + j * 12));
+                }
+                else if (op == OpCode::FlatPoly) {
+                    counts[model.TextureCount] += ReadPolygonLength(data, chunkStart) - 2;
+                }
+                else if (op == OpCode::MappedPoly) {
+                    auto tmap = data.ReadInt16(chunkStart + 28);
+                    if (tmap < 0 || tmap >= model.TextureCount) throw Exception("Model contains too many textures");
+                    counts[tmap] += ReadPolygonLength(data, chunkStart) - 2;
+                }
+            });
+        }
+
+        // Second pass: build an indexed mesh for each submodel
         int16 glow = -1;
         int16 glowIndex = 0, flatGlowIndex = 0;
-        List<Vector3> points;
-        auto& angles = model.angles;
+        std::unordered_map<SubmodelVertex, uint16, SubmodelVertexHash, SubmodelVertexEquals> vertexLookup;
 
-        // must use std::function instead of auto here to allow recursive calls
-        std::function<void(size_t, Submodel&)> ReadChunk = [&](size_t chunkStart, Submodel& submodel) {
-            reader.Seek(chunkStart);
-            auto op = (OpCode)reader.ReadInt16();
+        for (auto& i : loadOrder) {
+            auto& submodel = model.Submodels[i];
+            auto& counts = triangleCounts[i];
 
-            while (op != OpCode::End) {
-                int chunkLen = 0; // chunk length
+            size_t triangles = 0;
+            submodel.Indices.resize(slots);
+            for (int slot = 0; slot < slots; slot++) {
+                submodel.Indices[slot].reserve(counts[slot] * 3);
+                triangles += counts[slot];
+            }
 
-                switch (op) {
-                    case OpCode::DefPoints:
-                        throw NotImplementedException(); // unused
+            // Reserve for the worst case where no vertices are shared, then trim once the mesh is built
+            submodel.Vertices.reserve(triangles * 3);
+            vertexLookup.clear();
+            vertexLookup.reserve(triangles * 3);
+
+            auto getPoint = [&points](int16 index) -> const Vector3& {
+                if (index < 0 || index >= points.size()) throw Exception("Polygon point is out of range");
+                return points[index];
+            };
+
+            auto addVertex = [&](const SubmodelVertex& vertex, List<uint16>& indices) {
+                auto [match, inserted] = vertexLookup.try_emplace(vertex, (uint16)submodel.Vertices.size());
+                if (inserted) {
+                    if (submodel.Vertices.size() > UINT16_MAX) throw Exception("Submodel has too many vertices");
+                    submodel.Vertices.push_back(vertex);
+                }
 
-                    case OpCode::DefpointStart: // indicates the start of a submodel
-                    {
-                        auto n = reader.ReadInt16();
-                        // Discard the point index. This assumes that vertices are always stored in submodel order
-                        // which holds true for all official models.
-                        /*auto pointIndex =*/ reader.ReadInt16();
-                        auto zero = reader.ReadInt16();
-                        if (zero != 0) throw Exception("Defpoint Start must equal zero");
+                indices.push_back(match->second);
+            };
+
+            // Polygons are stored as triangle fans. Faces are flat shaded, so the normal is shared by the whole fan.
+            auto polygonNormal = [&](size_t indexStart, int16 n) {
+                auto& p0 = getPoint(data.ReadInt16(indexStart));
+                Vector3 normal;
+                for (int j = 1; j < n - 1; j++) {
+                    auto& p1 = getPoint(data.ReadInt16(indexStart + j * 2));
+                    auto& p2 = getPoint(data.ReadInt16(indexStart + j * 2 + 2));
+                    normal += (p1 - p0).Cross(p2 - p0);
+                }
 
-                        for (int i = 0; i < n; i++)
-                            points.push_back(reader.ReadVector());
+                normal.Normalize();
+                return normal;
+            };
 
-                        chunkLen = n * 12 /*sizeof(vector)*/ + 8;
-                        break;
-                    }
+            WalkChunks(data, submodel.Pointer, [&](OpCode op, size_t chunkStart) {
+                switch (op) {
                     case OpCode::FlatPoly:
                     {
-                        auto n = reader.ReadInt16();
-                        if (n <= 2 || n >= MAX_POINTS_PER_POLY)
-                            throw Exception("Polygon must have between 3 and 64 points");
-
-                        // vectors used for normal facing checks (no longer needed)
-                        /*auto v0 =*/ reader.ReadVector(); // @4
-                        /*auto v1 =*/ reader.ReadVector(); // @16
-                        
-                        auto color = reader.ReadUInt16();
+                        auto n = ReadPolygonLength(data, chunkStart);
+                        auto color = data.Read<uint16>(chunkStart + 28);
                         auto colorf = UnpackColor(color);
-                        
+
                         if (palette && color < palette->Data.size()) {
                             auto& c = palette->Data[color];
                             colorf = ColorFromRGB(c.r, c.g, c.b, c.a);
                         }
 
-                        int16 p0 = reader.ReadInt16();
-                        int16 px = reader.ReadInt16();
+                        auto indexStart = chunkStart + 30;
+                        auto normal = polygonNormal(indexStart, n);
+                        auto& indices = submodel.Indices[model.TextureCount];
+
+                        auto emit = [&](int j) {
+                            addVertex({ getPoint(data.ReadInt16(indexStart + j * 2)), Vector2(), colorf, normal }, indices);
+                        };
 
                         // convert triangle fans to triangle lists
-                        for (int i = 0; i < n - 2; i++) { // @30
-                            auto p = reader.ReadInt16();
-                            submodel.FlatIndices.push_back(p0);
-                            submodel.FlatIndices.push_back(px);
-                            submodel.FlatIndices.push_back(p);
-                            submodel.FlatVertexColors.push_back(colorf);
-                            px = p;
+                        for (int j = 1; j < n - 1; j++) {
+                            emit(0);
+                            emit(j);
+                            emit(j + 1);
 
                             if (glow >= 0)
                                 submodel.Glows.push_back({ flatGlowIndex, glow });
@@ -121,42 +266,28 @@ namespace Inferno {
                             flatGlowIndex++;
                         }
 
-                        int padding = n & 1 ? 0 : 2; // check if odd
-                        reader.SeekForward(padding);
-
-                        chunkLen = 30 + ((n & ~1) + 1) * 2;
-                        if (reader.Position() != chunkStart + chunkLen)
-                            throw Exception("Bad chunk length in POF FlatPoly");
-
                         break;
                     }
+
                     case OpCode::MappedPoly:
                     {
-                        // polygons are stored as triangle fans and can have more than 3 points
-                        auto n = reader.ReadInt16(); // @2
-                        if (n <= 2 || n >= MAX_POINTS_PER_POLY)
-                            throw Exception("Polygon must have between 3 and 64 points");
-
-                        // vectors used for normal facing checks (no longer needed)
-                        /*auto v0 =*/ reader.ReadVector(); // @4
-                        /*auto v1 =*/ reader.ReadVector(); // @16
-                        auto tmap = reader.ReadInt16(); // @28
-                        if (tmap > highestTex) highestTex = tmap;
-
-                        int16 p0 = reader.ReadInt16();
-                        int16 px = reader.ReadInt16();
-
-                        // this assert holds for official models, but not custom ones. however they can still draw properly regardless
-                        // assert(p0 < points.size() && px < points.size()); 
+                        auto n = ReadPolygonLength(data, chunkStart);
+                        auto tmap = data.ReadInt16(chunkStart + 28);
+                        auto indexStart = chunkStart + 30;
+                        auto uvStart = indexStart + PolygonIndicesSize(n);
+                        auto normal = polygonNormal(indexStart, n);
+                        auto& indices = submodel.Indices[tmap];
+
+                        auto emit = [&](int j) {
+                            auto uv = data.ReadVector(uvStart + j * 12);
+                            addVertex({ getPoint(data.ReadInt16(indexStart + j * 2)), Vector2(uv.x, uv.y), Color(1, 1, 1, 1), normal }, indices);
+                        };
 
                         // convert triangle fans to triangle lists
-                        for (int i = 0; i < n - 2; i++) { // @30
-                            auto p = reader.ReadInt16();
-                            submodel.Indices.push_back(p0);
-                            submodel.Indices.push_back(px);
-                            submodel.Indices.push_back(p);
-                            submodel.TMaps.push_back(tmap);
-                            px = p;
+                        for (int j = 1; j < n - 1; j++) {
+                            emit(0);
+                            emit(j);
+                            emit(j + 1);
 
                             if (glow >= 0)
                                 submodel.Glows.push_back({ glowIndex, glow });
@@ -164,88 +295,29 @@ namespace Inferno {
                             glowIndex++;
                         }
 
-                        int padding = n & 1 ? 0 : 2; // check if odd
-                        reader.SeekForward(padding);
-
-                        auto uv0 = reader.ReadVector();
-                        auto uvx = reader.ReadVector();
-
-                        for (int i = 0; i < n - 2; i++) {
-                            auto uv = reader.ReadVector();
-                            submodel.UVs.push_back(uv0);
-                            submodel.UVs.push_back(uvx);
-                            submodel.UVs.push_back(uv);
-                            uvx = uv;
-                        }
-
-                        chunkLen = 30 + ((n & ~1) + 1) * 2 + n * 12; // n & ~1 skips index 0 and 1
-                        if (reader.Position() != chunkStart + chunkLen)
-                            throw Exception("Bad chunk length in POF MappedPoly");
-
                         glow = -1;
                         break;
                     }
-                    case OpCode::SortNormal:
-                    {
-                        reader.Seek(chunkStart + 28);
-                        auto offset1 = reader.ReadInt16();
-                        auto offset2 = reader.ReadInt16();
-                        ReadChunk(chunkStart + offset2, submodel);
-                        ReadChunk(chunkStart + offset1, submodel);
-                        chunkLen = 32;
-                        break;
-                    }
-                    case OpCode::RodBitmap:
-                        // Unused. Might have been intended for the energy drain robot.
-                        throw NotImplementedException();
 
                     case OpCode::CallSubobject:
                     {
-                        angles.push_back(reader.ReadAngleVec());
-                        reader.Seek(chunkStart + 16);
-                        auto offset = reader.ReadInt16();
-                        ReadChunk(chunkStart + offset, submodel);
-                        chunkLen = 20;
+                        auto angles = Vector3(FixToFloat(data.ReadInt16(chunkStart + 2)),
+                                              FixToFloat(data.ReadInt16(chunkStart + 4)),
+                                              FixToFloat(data.ReadInt16(chunkStart + 6)));
+                        model.angles.push_back(angles);
                         break;
                     }
+
                     case OpCode::Glow:
                         // glow gets consumed by the next textured polygon
                         // glow 0: engine, brightness based on velocity
                         // glow 1: player ship headlight
-                        glow = reader.ReadInt16();
-                        chunkLen = 4;
+                        glow = data.ReadInt16(chunkStart + 2);
                         break;
-
-                    default:
-                        throw Exception("Error parsing POF data");
                 }
+            });
 
-                assert(chunkLen != 0); // forgot to set the length of a chunk
-                reader.Seek(chunkStart + chunkLen);
-                chunkStart = reader.Position();
-                op = (OpCode)reader.ReadInt16();
-            }
-        };
-
-        // Submodels must be loaded in order of pointer offset.
-        // Doing this allows extracting all mesh data ahead of time instead of per frame.
-        List<int> pointers = Seq::map(model.Submodels, [](const auto& sm) { return sm.Pointer; });
-        List<int16> loadOrder(pointers.size());
-        std::iota(loadOrder.begin(), loadOrder.end(), (int16)0); // fill range 0 .. n
-        Seq::sortBy(loadOrder, [&pointers](auto a, auto b) {
-            return pointers[a] < pointers[b]; // sort load order by pointer offsets
-        });
-
-        // Load the sorted submodels
-        for (auto& i : loadOrder) {
-            auto& submodel = model.Submodels[i];
-            ReadChunk(submodel.Pointer, submodel);
+            submodel.Vertices.shrink_to_fit();
         }
-
-        Expand(model, points);
-
-        if (highestTex >= model.TextureCount) throw Exception("Model contains too many textures");
-        if (model.Submodels.size() > MAX_SUBMODELS) throw Exception("Model contains too many submodels");
     }
-}
-
+}
\ No newline at end of file
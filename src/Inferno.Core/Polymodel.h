@@ -18,6 +18,14 @@ namespace Inferno {
         int16 Glow;
     };
 
+    // Vertex of a submodel mesh
+    struct SubmodelVertex {
+        Vector3 Position;
+        Vector2 UV;
+        Color Color;
+        Vector3 Normal;
+    };
+
     struct Submodel {
         int Pointer;
         Vector3 Offset;
@@ -28,20 +36,11 @@ namespace Inferno {
         Vector3 Min;
         Vector3 Max;
 
-        // Mesh data
-        List<uint16> Indices;
-        List<Vector3> UVs;
-        List<uint16> FlatIndices;
-        List<int16> TMaps;
-        List<Color> FlatVertexColors;
+        // Mesh data. Identical vertices are shared between triangles.
+        List<SubmodelVertex> Vertices;
+        // Triangle list for each texture slot. The last slot is for flat polygons.
+        List<List<uint16>> Indices;
         List<SubmodelGlow> Glows;
-        List<SubmodelGlow> FlatGlows;
-
-        // expanded values so that each face gets its own vertices / uvs
-        List<Vector3> ExpandedPoints;
-        // The top level list corresponds to the texture slot
-        List<List<uint16>> ExpandedIndices;
-        List<Color> ExpandedColors;
     };
 
     // Parallax Object Format
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Types.h"
+
+namespace Inferno {
+    struct ResidencyStats {
+        size_t ResidentBytes = 0;
+        size_t ResidentCount = 0;
+        size_t Budget = 0; // Zero when unlimited
+        int64 Evictions = 0; // Entries unloaded to stay under the budget
+        int64 ReloadMisses = 0; // Evicted entries that were needed again
+    };
+
+    // Decides which resources to unload to keep memory under a budget.
+    // Only does bookkeeping, the owner performs the actual loading and unloading.
+    // Pinned entries and entries used within the last few frames are never evicted.
+    // Other entries are evicted least recently used first. Not thread safe.
+    template<class TKey>
+    class ResidencyTracker {
+        struct Entry {
+            size_t Bytes = 0;
+            uint64 LastUsed = 0; // Frame the entry was last used
+            bool Resident = false; // False when the entry was evicted
+        };
+
+        Dictionary<TKey, Entry> _entries;
+        Set<TKey> _pinned;
+        uint64 _frame = 0;
+        ResidencyStats _stats;
+
+    public:
+        // Sets the memory budget in bytes. Zero disables eviction.
+        void SetBudget(size_t bytes) { _stats.Budget = bytes; }
+
+        // Records a resource as loaded. Counts a reload miss if it was previously evicted.
+        void Add(const TKey& key, size_t bytes) {
+            auto& entry = _entries[key];
+            if (entry.Resident) _stats.ResidentBytes -= entry.Bytes;
+            else _stats.ResidentCount++;
+
+            if (!entry.Resident && entry.LastUsed > 0)
+                _stats.ReloadMisses++;
+
+            entry.Bytes = bytes;
+            entry.Resident = true;
+            entry.LastUsed = _frame + 1;
+            _stats.ResidentBytes += bytes;
+        }
+
+        // Records a resource as unloaded by the owner, such as when pruning. Not counted as an eviction.
+        void Remove(const TKey& key) {
+            auto entry = _entries.find(key);
+            if (entry == _entries.end()) return;
+
+            if (entry->second.Resident) {
+                _stats.ResidentBytes -= entry->second.Bytes;
+                _stats.ResidentCount--;
+            }
+
+            _entries.erase(entry);
+        }
+
+        void Clear() {
+            _entries.clear();
+            _stats.ResidentBytes = _stats.ResidentCount = 0;
+        }
+
+        // Marks a resource as used this frame. Returns true if it was evicted and should be reloaded.
+        bool Touch(const TKey& key) {
+            auto entry = _entries.find(key);
+            if (entry == _entries.end()) return false;
+            entry->second.LastUsed = _frame + 1;
+            return !entry->second.Resident;
+        }
+
+        // Replaces the pinned resources, such as the textures referenced by the current level
+        void SetPinned(Set<TKey> keys) { _pinned = std::move(keys); }
+        void Pin(const TKey& key) { _pinned.insert(key); }
+        bool IsPinned(const TKey& key) const { return _pinned.contains(key); }
+
+        // Call once per frame before any Touch()
+        void NextFrame() { _frame++; }
+
+        bool IsOverBudget() const {
+            return _stats.Budget > 0 && _stats.ResidentBytes > _stats.Budget;
+        }
+
+        // Returns the resources to unload to get under the budget, least recently used first.
+        // Resources used within the last recentFrames frames are kept even if the budget is exceeded.
+        List<TKey> Evict(uint64 recentFrames) {
+            if (!IsOverBudget()) return {};
+
+            List<std::pair<uint64, TKey>> candidates;
+            for (auto& [key, entry] : _entries) {
+                if (!entry.Resident || _pinned.contains(key)) continue;
+                if (entry.LastUsed + recentFrames > _frame) continue;
+                candidates.push_back({ entry.LastUsed, key });
+            }
+
+            ranges::sort(candidates, {}, [](auto& c) { return c.first; });
+
+            List<TKey> evicted;
+            for (auto& [lastUsed, key] : candidates) {
+                if (!IsOverBudget()) break;
+
+                auto& entry = _entries[key];
+                entry.Resident = false;
+                _stats.ResidentBytes -= entry.Bytes;
+                _stats.ResidentCount--;
+                _stats.Evictions++;
+                evicted.push_back(key);
+            }
+
+            return evicted;
+        }
+
+        const ResidencyStats& GetStats() const { return _stats; }
+    };
+}
\ No newline at end of file
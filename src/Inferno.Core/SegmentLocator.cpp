@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "SegmentLocator.h"
+#include "Face.h"
+
+namespace Inferno {
+    namespace {
+        int CellCoord(float x) {
+            return (int)std::floor(x / SegmentLocator::CELL_SIZE);
+        }
+
+        uint64 CellKey(int x, int y, int z) {
+            constexpr uint64 mask = (1 << 21) - 1;
+            return ((uint64)x & mask) << 42 | ((uint64)y & mask) << 21 | ((uint64)z & mask);
+        }
+    }
+
+    bool SegmentLocator::Contains(Level& level, SegID id, const Vector3& point) {
+        if (!level.SegmentExists(id)) return false;
+
+        for (auto& side : SideIDs) {
+            auto face = Face::FromSide(level, id, side);
+            if (face.Distance(point) < 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    SegID SegmentLocator::Find(Level& level, const Vector3& point, SegID hint) {
+        if (auto id = Walk(level, point, hint); id != SegID::None)
+            return id;
+
+        if (!_valid || _segmentCount != level.Segments.size())
+            Rebuild(level);
+
+        auto cell = _cells.find(CellKey(CellCoord(point.x), CellCoord(point.y), CellCoord(point.z)));
+        if (cell != _cells.end()) {
+            // Segments are stored in ascending order, so overlapping segments resolve the same way as a linear search
+            for (auto& id : cell->second) {
+                auto& bounds = _bounds[(int)id];
+                if (point.x < bounds.Min.x || point.y < bounds.Min.y || point.z < bounds.Min.z ||
+                    point.x > bounds.Max.x || point.y > bounds.Max.y || point.z > bounds.Max.z)
+                    continue;
+
+                if (Contains(level, id, point))
+                    return id;
+            }
+        }
+
+        // The bounds can be out of date if vertices moved without an invalidate,
+        // so check nearby segments before giving up
+        for (int id = 0; id < level.Segments.size(); id++) {
+            auto& seg = level.GetSegment((SegID)id);
+            if (Vector3::Distance(seg.Center, point) > 200) continue;
+
+            if (Contains(level, (SegID)id, point)) {
+                _valid = false;
+                return (SegID)id;
+            }
+        }
+
+        return SegID::None;
+    }
+
+    SegID SegmentLocator::Walk(Level& level, const Vector3& point, SegID start) const {
+        auto id = start;
+        auto prev = SegID::None;
+
+        for (int step = 0; step < MAX_WALK_STEPS; step++) {
+            auto seg = level.TryGetSegment(id);
+            if (!seg) return SegID::None;
+
+            // Move through the side the point is furthest behind
+            auto exit = SideID::None;
+            float exitDist = 0;
+
+            for (auto& side : SideIDs) {
+                auto dist = Face::FromSide(level, *seg, side).Distance(point);
+                if (dist < exitDist) {
+                    exitDist = dist;
+                    exit = side;
+                }
+            }
+
+            if (exit == SideID::None)
+                return id; // In front of every side
+
+            auto next = seg->GetConnection(exit);
+            if (!level.SegmentExists(next) || next == prev)
+                return SegID::None; // Left the level or started going back and forth
+
+            prev = id;
+            id = next;
+        }
+
+        return SegID::None;
+    }
+
+    void SegmentLocator::Rebuild(Level& level) {
+        _bounds.resize(level.Segments.size());
+        _cells.clear();
+
+        for (int id = 0; id < level.Segments.size(); id++) {
+            auto& seg = level.Segments[id];
+            Vector3 min(FLT_MAX), max(-FLT_MAX);
+
+            for (auto& index : seg.Indices) {
+                if (!Seq::inRange(level.Vertices, index)) continue;
+                auto& v = level.Vertices[index];
+                min = Vector3::Min(min, v);
+                max = Vector3::Max(max, v);
+            }
+
+            if (min.x > max.x) {
+                _bounds[id] = {}; // No valid vertices
+                continue;
+            }
+
+            min -= Vector3(BOUNDS_PADDING);
+            max += Vector3(BOUNDS_PADDING);
+            _bounds[id] = { min, max };
+
+            for (int x = CellCoord(min.x); x <= CellCoord(max.x); x++) {
+                for (int y = CellCoord(min.y); y <= CellCoord(max.y); y++) {
+                    for (int z = CellCoord(min.z); z <= CellCoord(max.z); z++)
+                        _cells[CellKey(x, y, z)].push_back((SegID)id);
+                }
+            }
+        }
+
+        _segmentCount = level.Segments.size();
+        _valid = true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Level.h"
+
+namespace Inferno {
+    // Finds the segment containing a point. Walks the segment connections starting from a hint segment,
+    // then falls back to a grid of segment bounds.
+    class SegmentLocator {
+        struct Bounds { Vector3 Min, Max; };
+
+        List<Bounds> _bounds;
+        Dictionary<uint64, List<SegID>> _cells; // Segments overlapping each grid cell
+        size_t _segmentCount = 0;
+        bool _valid = false;
+
+    public:
+        static constexpr float CELL_SIZE = 40; // Roughly two default sized segments
+        static constexpr float BOUNDS_PADDING = 1; // Sides are treated as planes, so points can be slightly outside the vertices
+        static constexpr int MAX_WALK_STEPS = 32;
+
+        // Returns the segment containing the point or None.
+        // The hint should be a segment near the point, such as the previous segment of a moved object.
+        SegID Find(Level& level, const Vector3& point, SegID hint = SegID::None);
+
+        // Marks the bounds as out of date. Call after moving vertices or adding segments.
+        void Invalidate() { _valid = false; }
+
+        // Estimation that treats the sides as planes instead of triangles
+        static bool Contains(Level& level, SegID id, const Vector3& point);
+
+    private:
+        SegID Walk(Level& level, const Vector3& point, SegID start) const;
+        void Rebuild(Level& level);
+    };
+}
\ No newline at end of file
@@ -40,4 +40,19 @@ namespace Inferno {
         reader.Seek(DataStart + sound.Offset);
         return reader.ReadUBytes(sound.Length);
     }
+
+    List<List<ubyte>> SoundFile::Read(span<const int> indices) const {
+        List<List<ubyte>> data(indices.size());
+        if (indices.empty()) return data;
+        StreamReader reader(Path);
+
+        for (size_t i = 0; i < indices.size(); i++) {
+            if (!Seq::inRange(Sounds, indices[i])) continue;
+            auto& sound = Sounds[indices[i]];
+            reader.Seek(DataStart + sound.Offset);
+            data[i] = reader.ReadUBytes(sound.Length);
+        }
+
+        return data;
+    }
 }
\ No newline at end of file
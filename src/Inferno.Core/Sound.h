@@ -25,6 +25,8 @@ namespace Inferno {
         size_t DataStart = 0u;
 
         List<ubyte> Read(int index) const;
+        // Reads several sounds while keeping the file open. Missing indices return empty data.
+        List<List<ubyte>> Read(span<const int> indices) const;
     };
 
     SoundFile::Header ReadSoundHeader(StreamReader& reader);
@@ -213,6 +213,9 @@ namespace Inferno {
             return Color(r / 255.0f, g / 255.0f, b / 255.0f);
         }
 
+        // True if a read went past the end of the stream or failed
+        bool Failed() const { return _stream->fail(); }
+
         bool EndOfStream() { 
             _stream->peek(); // need to peek to ensure EOF is correct
             return _stream->eof(); 
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "TrianglePacket.h"
+
+using namespace DirectX;
+
+namespace Inferno {
+    namespace {
+        constexpr float RAY_EPSILON = 1e-20f; // Same as the DirectXMath triangle test
+
+        XMVECTOR Load(const Array<float, 4>& xs) {
+            return XMLoadFloat4((const XMFLOAT4*)xs.data());
+        }
+    }
+
+    void TrianglePacket::Add(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& cullNormal) {
+        assert(Count < SIZE);
+        auto e1 = p1 - p0;
+        auto e2 = p2 - p0;
+
+        X[Count] = p0.x;
+        Y[Count] = p0.y;
+        Z[Count] = p0.z;
+        E1X[Count] = e1.x;
+        E1Y[Count] = e1.y;
+        E1Z[Count] = e1.z;
+        E2X[Count] = e2.x;
+        E2Y[Count] = e2.y;
+        E2Z[Count] = e2.z;
+        NX[Count] = cullNormal.x;
+        NY[Count] = cullNormal.y;
+        NZ[Count] = cullNormal.z;
+        Count++;
+    }
+
+    // Moller-Trumbore on four triangles at a time
+    uint IntersectPacket(const Ray& ray, const TrianglePacket& packet, float maxDist, Array<float, 4>* distances) {
+        auto zero = XMVectorZero();
+        auto epsilon = XMVectorReplicate(RAY_EPSILON);
+        auto dx = XMVectorReplicate(ray.direction.x);
+        auto dy = XMVectorReplicate(ray.direction.y);
+        auto dz = XMVectorReplicate(ray.direction.z);
+
+        auto e1x = Load(packet.E1X), e1y = Load(packet.E1Y), e1z = Load(packet.E1Z);
+        auto e2x = Load(packet.E2X), e2y = Load(packet.E2Y), e2z = Load(packet.E2Z);
+
+        // p = direction x e2
+        auto px = XMVectorNegativeMultiplySubtract(dz, e2y, XMVectorMultiply(dy, e2z));
+        auto py = XMVectorNegativeMultiplySubtract(dx, e2z, XMVectorMultiply(dz, e2x));
+        auto pz = XMVectorNegativeMultiplySubtract(dy, e2x, XMVectorMultiply(dx, e2y));
+
+        // det = e1 . p
+        auto det = XMVectorMultiplyAdd(e1z, pz, XMVectorMultiplyAdd(e1y, py, XMVectorMultiply(e1x, px)));
+
+        // s = origin - v0
+        auto sx = XMVectorSubtract(XMVectorReplicate(ray.position.x), Load(packet.X));
+        auto sy = XMVectorSubtract(XMVectorReplicate(ray.position.y), Load(packet.Y));
+        auto sz = XMVectorSubtract(XMVectorReplicate(ray.position.z), Load(packet.Z));
+
+        // u = s . p
+        auto u = XMVectorMultiplyAdd(sz, pz, XMVectorMultiplyAdd(sy, py, XMVectorMultiply(sx, px)));
+
+        // q = s x e1
+        auto qx = XMVectorNegativeMultiplySubtract(sz, e1y, XMVectorMultiply(sy, e1z));
+        auto qy = XMVectorNegativeMultiplySubtract(sx, e1z, XMVectorMultiply(sz, e1x));
+        auto qz = XMVectorNegativeMultiplySubtract(sy, e1x, XMVectorMultiply(sx, e1y));
+
+        // v = direction . q, t = e2 . q
+        auto v = XMVectorMultiplyAdd(dz, qz, XMVectorMultiplyAdd(dy, qy, XMVectorMultiply(dx, qx)));
+        auto t = XMVectorMultiplyAdd(e2z, qz, XMVectorMultiplyAdd(e2y, qy, XMVectorMultiply(e2x, qx)));
+        auto uv = XMVectorAdd(u, v);
+
+        // Front side of the triangle, u, v and t have the same sign as det
+        auto frontMiss = XMVectorOrInt(XMVectorLess(u, zero), XMVectorGreater(u, det));
+        frontMiss = XMVectorOrInt(frontMiss, XMVectorLess(v, zero));
+        frontMiss = XMVectorOrInt(frontMiss, XMVectorGreater(uv, det));
+        frontMiss = XMVectorOrInt(frontMiss, XMVectorLess(t, zero));
+        auto front = XMVectorAndCInt(XMVectorGreaterOrEqual(det, epsilon), frontMiss);
+
+        // Back side of the triangle
+        auto backMiss = XMVectorOrInt(XMVectorGreater(u, zero), XMVectorLess(u, det));
+        backMiss = XMVectorOrInt(backMiss, XMVectorGreater(v, zero));
+        backMiss = XMVectorOrInt(backMiss, XMVectorLess(uv, det));
+        backMiss = XMVectorOrInt(backMiss, XMVectorGreater(t, zero));
+        auto back = XMVectorAndCInt(XMVectorLessOrEqual(det, XMVectorNegate(epsilon)), backMiss);
+
+        // Parallel rays and unused lanes have a det of zero and are excluded above
+        auto dist = XMVectorDivide(t, det);
+        auto hit = XMVectorAndInt(XMVectorOrInt(front, back), XMVectorLess(dist, XMVectorReplicate(maxDist)));
+
+        // Skip triangles facing away from the ray
+        auto facing = XMVectorMultiplyAdd(dz, Load(packet.NZ), XMVectorMultiplyAdd(dy, Load(packet.NY), XMVectorMultiply(dx, Load(packet.NX))));
+        hit = XMVectorAndCInt(hit, XMVectorGreater(facing, zero));
+
+        XMUINT4 lanes;
+        XMStoreUInt4(&lanes, hit);
+        uint mask = (lanes.x & 1) | (lanes.y & 1) << 1 | (lanes.z & 1) << 2 | (lanes.w & 1) << 3;
+
+        if (mask && distances)
+            XMStoreFloat4((XMFLOAT4*)distances->data(), dist);
+
+        return mask;
+    }
+
+    Array<Option<float>, 6> IntersectSides(const Level& level, const Segment& seg, const Ray& ray, bool hitBackface) {
+        Array<Option<float>, 6> hits{};
+        auto& verts = level.Vertices;
+
+        // Two sides per packet, with the triangles of each side in adjacent lanes
+        for (int first = 0; first < 6; first += 2) {
+            TrianglePacket packet;
+
+            for (int sideIndex = first; sideIndex < first + 2; sideIndex++) {
+                auto sideId = SideID(sideIndex);
+                auto& side = seg.GetSide(sideId);
+                auto indices = seg.GetVertexIndices(sideId);
+                auto ri = side.GetRenderIndices();
+
+                packet.Add(verts[indices[ri[0]]], verts[indices[ri[1]]], verts[indices[ri[2]]], hitBackface ? Vector3::Zero : side.Normals[0]);
+                packet.Add(verts[indices[ri[3]]], verts[indices[ri[4]]], verts[indices[ri[5]]], hitBackface ? Vector3::Zero : side.Normals[1]);
+            }
+
+            Array<float, 4> distances;
+            auto mask = IntersectPacket(ray, packet, FLT_MAX, &distances);
+
+            for (int i = 0; i < 2; i++) {
+                auto lane = i * 2;
+                if (mask & (1 << lane))
+                    hits[first + i] = distances[lane];
+                else if (mask & (1 << (lane + 1)))
+                    hits[first + i] = distances[lane + 1];
+            }
+        }
+
+        return hits;
+    }
+}
\ No newline at end of file
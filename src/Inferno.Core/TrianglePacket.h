@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Types.h"
+#include "Level.h"
+
+namespace Inferno {
+    // Four triangles stored as a structure of arrays so a ray can be tested against all of them at once.
+    // Unused lanes are degenerate and never hit.
+    struct TrianglePacket {
+        static constexpr int SIZE = 4;
+
+        Array<float, SIZE> X{}, Y{}, Z{}; // First vertex
+        Array<float, SIZE> E1X{}, E1Y{}, E1Z{}; // Edge from the first to the second vertex
+        Array<float, SIZE> E2X{}, E2Y{}, E2Z{}; // Edge from the first to the third vertex
+        Array<float, SIZE> NX{}, NY{}, NZ{}; // Rays pointing the same way as this normal are ignored. Zero hits both sides.
+        int Count = 0;
+
+        bool IsFull() const { return Count == SIZE; }
+
+        void Add(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& cullNormal = Vector3::Zero);
+    };
+
+    // Tests a ray against every triangle in the packet. Hits are the same as calling Ray::Intersects on each triangle.
+    // Returns a bit for each triangle hit closer than maxDist and writes their distances if provided.
+    uint IntersectPacket(const Ray& ray, const TrianglePacket& packet, float maxDist = FLT_MAX, Array<float, 4>* distances = nullptr);
+
+    // Returns the distance to each side of the segment hit by the ray. Matches Face::Intersects.
+    Array<Option<float>, 6> IntersectSides(const Level& level, const Segment& seg, const Ray& ray, bool hitBackface = false);
+}
\ No newline at end of file
@@ -13,6 +13,16 @@ namespace Inferno {
         return cc[0] | cc[1] << 8 | cc[2] << 16 | cc[3] << 24;
     }
 
+    // 64-bit FNV-1a hash of a buffer. Pass a previous result as the seed to combine buffers.
+    constexpr uint64 HashBytes(span<const ubyte> data, uint64 hash = 0xcbf29ce484222325) {
+        for (auto& b : data) {
+            hash ^= b;
+            hash *= 0x100000001b3;
+        }
+
+        return hash;
+    }
+
     //constexpr std::array<char, 4> DecodeFourCC(uint32 value) {
     //    std::array<char, 4> cc{};
     //    cc[0] = char(value & 0x000000ff);
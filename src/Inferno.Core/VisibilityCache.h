@@ -0,0 +1,106 @@
+#pragma once
+
+#include <bit>
+#include "Types.h"
+
+namespace Inferno {
+    // Open addressing table of visibility results keyed by a pair of points.
+    // Each entry packs the key with a known and an occluded bit into 8 bytes, instead of allocating a node per result.
+    // Reads are safe from multiple threads as long as nothing is inserted.
+    class VisibilityCache {
+        static constexpr uint64 OCCLUDED = 1 << 0;
+        static constexpr uint64 KNOWN = 1 << 1; // Distinguishes key 0 from an empty slot
+        static constexpr size_t MIN_CAPACITY = 16;
+
+        List<uint64> _entries; // Zero is an empty slot
+        size_t _count = 0;
+
+    public:
+        static constexpr uint64 MAX_KEY = (1ull << 62) - 1;
+
+        VisibilityCache(size_t capacity = 0) { Reserve(capacity); }
+
+        // Returns the cached result for a key. Empty if the pair hasn't been tested.
+        Option<bool> Find(uint64 key) const {
+            if (_entries.empty()) return {};
+            auto mask = _entries.size() - 1;
+
+            for (auto i = Hash(key) & mask; _entries[i] != 0; i = (i + 1) & mask) {
+                if (_entries[i] >> 2 == key)
+                    return (_entries[i] & OCCLUDED) != 0;
+            }
+
+            return {};
+        }
+
+        void Insert(uint64 key, bool occluded) {
+            assert(key <= MAX_KEY);
+            InsertEntry(key << 2 | KNOWN | (occluded ? OCCLUDED : 0));
+        }
+
+        // Copies all results from another cache
+        void Merge(const VisibilityCache& other) {
+            Reserve(_count + other._count);
+
+            for (auto& entry : other._entries)
+                if (entry != 0) InsertEntry(entry);
+        }
+
+        // Ensures the table can hold a number of results without growing
+        void Reserve(size_t count) {
+            auto capacity = std::bit_ceil(std::max(count * 2, MIN_CAPACITY)); // Keep the load under half
+            if (capacity <= _entries.size()) return;
+
+            auto entries = std::move(_entries);
+            _entries.assign(capacity, 0);
+            _count = 0;
+
+            for (auto& entry : entries)
+                if (entry != 0) InsertEntry(entry);
+        }
+
+        // Calls fn(key, occluded) for every result
+        void ForEach(auto&& fn) const {
+            for (auto& entry : _entries)
+                if (entry != 0) fn(entry >> 2, (entry & OCCLUDED) != 0);
+        }
+
+        void Clear() {
+            _entries = {};
+            _count = 0;
+        }
+
+        size_t Count() const { return _count; }
+        size_t MemoryUsage() const { return _entries.size() * sizeof(uint64); }
+
+    private:
+        void InsertEntry(uint64 entry) {
+            if ((_count + 1) * 2 > _entries.size())
+                Reserve(_count + 1);
+
+            auto mask = _entries.size() - 1;
+            auto key = entry >> 2;
+            auto i = Hash(key) & mask;
+
+            for (; _entries[i] != 0; i = (i + 1) & mask) {
+                if (_entries[i] >> 2 == key) {
+                    _entries[i] = entry; // Replace the existing result
+                    return;
+                }
+            }
+
+            _entries[i] = entry;
+            _count++;
+        }
+
+        // Mixes the packed keys so that neighboring ids spread across the table
+        static constexpr size_t Hash(uint64 key) {
+            key ^= key >> 30;
+            key *= 0xbf58476d1ce4e5b9ull;
+            key ^= key >> 27;
+            key *= 0x94d049bb133111ebull;
+            key ^= key >> 31;
+            return (size_t)key;
+        }
+    };
+}
\ No newline at end of file
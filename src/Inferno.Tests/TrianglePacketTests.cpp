@@ -0,0 +1,286 @@
+#include "pch.h"
+#include <bit>
+#include <random>
+#include <chrono>
+#include "TrianglePacket.h"
+#include "Face.h"
+
+// Checks that the packet ray tests match the scalar triangle tests they replace.
+// Run with --benchmark to also time the packet path against the scalar one.
+
+using namespace Inferno;
+
+#define CHECK(expr) \
+    do { if (!(expr)) { Failures++; fmt::print("{}({}): CHECK failed: {}\n", __FILE__, __LINE__, #expr); } } while (0)
+
+namespace {
+    int Failures = 0;
+
+    constexpr float DIST_TOLERANCE = 1e-3f;
+
+    struct Random {
+        std::mt19937 Engine{ 1 };
+
+        float Next(float min, float max) {
+            return std::uniform_real_distribution(min, max)(Engine);
+        }
+
+        Vector3 Point(float extent = 10) {
+            return { Next(-extent, extent), Next(-extent, extent), Next(-extent, extent) };
+        }
+
+        Ray NextRay(float extent = 10) {
+            auto dir = Point();
+            dir.Normalize();
+            return { Point(extent), dir };
+        }
+    };
+
+    struct Triangle {
+        Vector3 P0, P1, P2;
+        Vector3 CullNormal;
+    };
+
+    // Ray::Intersects on a single triangle, with the same culling and max distance as IntersectPacket
+    Option<float> IntersectScalar(const Ray& ray, const Triangle& tri, float maxDist) {
+        if (tri.CullNormal.Dot(ray.direction) > 0)
+            return {};
+
+        float dist{};
+        if (!ray.Intersects(tri.P0, tri.P1, tri.P2, dist) || dist >= maxDist)
+            return {};
+
+        return dist;
+    }
+
+    TrianglePacket MakePacket(span<const Triangle> tris) {
+        TrianglePacket packet;
+        for (auto& tri : tris)
+            packet.Add(tri.P0, tri.P1, tri.P2, tri.CullNormal);
+        return packet;
+    }
+
+    void CheckPacketMatchesScalar(const Ray& ray, span<const Triangle> tris, float maxDist) {
+        auto packet = MakePacket(tris);
+        Array<float, 4> distances{};
+        auto mask = IntersectPacket(ray, packet, maxDist, &distances);
+
+        for (int lane = 0; lane < TrianglePacket::SIZE; lane++) {
+            bool hit = mask & (1 << lane);
+
+            if (lane >= (int)tris.size()) {
+                CHECK(!hit); // Unused lanes never hit
+                continue;
+            }
+
+            auto expected = IntersectScalar(ray, tris[lane], maxDist);
+            CHECK(hit == expected.has_value());
+            if (hit && expected)
+                CHECK(std::abs(distances[lane] - *expected) <= DIST_TOLERANCE * std::max(1.0f, *expected));
+        }
+    }
+
+    // Random triangles and rays, mixed with degenerate triangles
+    void TestRandomTriangles() {
+        Random random;
+
+        for (int n = 0; n < 100'000; n++) {
+            auto ray = random.NextRay();
+            int count = 1 + n % TrianglePacket::SIZE;
+            Triangle tris[TrianglePacket::SIZE];
+
+            for (int i = 0; i < count; i++) {
+                auto& tri = tris[i];
+                tri.P0 = random.Point();
+                tri.P1 = random.Point();
+                tri.P2 = random.Point();
+
+                switch ((n + i) % 8) {
+                    case 0: tri.P2 = tri.P1; break; // Duplicate vertex
+                    case 1: tri.P2 = tri.P0 + (tri.P1 - tri.P0) * 0.5f; break; // Collinear
+                    case 2: tri.P1 = tri.P2 = tri.P0; break; // Single point
+                    case 3: tri.CullNormal = (tri.P1 - tri.P0).Cross(tri.P2 - tri.P0); break;
+                    default: break;
+                }
+            }
+
+            float maxDist = n % 3 == 0 ? 5.0f : FLT_MAX;
+            CheckPacketMatchesScalar(ray, { tris, (size_t)count }, maxDist);
+        }
+    }
+
+    void TestDegenerateTriangles() {
+        // The ray passes directly through every vertex and edge of these triangles
+        Ray ray = { { 0, 0, -5 }, { 0, 0, 1 } };
+        Vector3 origin = { 0, 0, 0 };
+        Vector3 edge = { 1, 0, 0 };
+
+        Triangle tris[] = {
+            { origin, origin, origin }, // Zero area point
+            { origin, edge, edge }, // Duplicate vertex
+            { -edge, origin, edge }, // Collinear
+            { edge, -edge, origin } // Collinear, reversed winding
+        };
+
+        auto packet = MakePacket(tris);
+        CHECK(IntersectPacket(ray, packet) == 0);
+        CheckPacketMatchesScalar(ray, tris, FLT_MAX);
+    }
+
+    void TestEmptyPacket() {
+        TrianglePacket packet;
+        Ray ray = { { 0, 0, 0 }, { 0, 0, 1 } };
+        Array<float, 4> distances{};
+        CHECK(IntersectPacket(ray, packet, FLT_MAX, &distances) == 0);
+    }
+
+    void TestHitsAndCulling() {
+        // Triangle facing -Z at z = 10
+        Triangle tri = { { -1, -1, 10 }, { 1, -1, 10 }, { 0, 1, 10 } };
+        Ray forward = { { 0, 0, 0 }, { 0, 0, 1 } };
+        Ray parallel = { { 0, 0, 0 }, { 1, 0, 0 } };
+        Ray away = { { 0, 0, 0 }, { 0, 0, -1 } };
+
+        Array<float, 4> distances{};
+        auto packet = MakePacket({ &tri, 1 });
+        CHECK(IntersectPacket(forward, packet, FLT_MAX, &distances) == 1);
+        CHECK(std::abs(distances[0] - 10) <= DIST_TOLERANCE);
+        CHECK(IntersectPacket(parallel, packet) == 0);
+        CHECK(IntersectPacket(away, packet) == 0);
+        CHECK(IntersectPacket(forward, packet, 10) == 0); // maxDist is exclusive
+        CHECK(IntersectPacket(forward, packet, 10.5f) == 1);
+
+        // Both windings hit without a cull normal
+        Triangle reversed = { tri.P0, tri.P2, tri.P1 };
+        CHECK(IntersectPacket(forward, MakePacket({ &reversed, 1 })) == 1);
+
+        // Rays pointing the same way as the cull normal are skipped
+        tri.CullNormal = { 0, 0, 1 };
+        CHECK(IntersectPacket(forward, MakePacket({ &tri, 1 })) == 0);
+        tri.CullNormal = { 0, 0, -1 };
+        CHECK(IntersectPacket(forward, MakePacket({ &tri, 1 })) == 1);
+    }
+
+    Level CreateTestLevel(Random& random) {
+        Level level;
+
+        // Cube with jittered corners so sides are split into non-coplanar triangles
+        Array<Vector3, 8> verts = {
+            Vector3{ 10, 10, -10 },
+            Vector3{ 10, -10, -10 },
+            Vector3{ -10, -10, -10 },
+            Vector3{ -10, 10, -10 },
+            Vector3{ 10, 10, 10 },
+            Vector3{ 10, -10, 10 },
+            Vector3{ -10, -10, 10 },
+            Vector3{ -10, 10, 10 }
+        };
+
+        Segment seg{};
+        for (uint16 i = 0; i < 8; i++) {
+            level.Vertices.push_back(verts[i] + random.Point(2));
+            seg.Indices[i] = i;
+        }
+
+        seg.UpdateGeometricProps(level);
+        level.Segments.push_back(seg);
+        return level;
+    }
+
+    void TestIntersectSides() {
+        Random random;
+
+        for (int n = 0; n < 1'000; n++) {
+            auto level = CreateTestLevel(random);
+            auto& seg = level.Segments[0];
+
+            for (int r = 0; r < 50; r++) {
+                auto ray = random.NextRay(r % 2 ? 8.0f : 20.0f); // Start inside or outside of the segment
+
+                for (bool hitBackface : { false, true }) {
+                    auto hits = IntersectSides(level, seg, ray, hitBackface);
+
+                    for (auto& sideId : SideIDs) {
+                        auto face = Face::FromSide(level, seg, sideId);
+                        float dist{};
+                        bool expected = face.Intersects(ray, dist, hitBackface);
+                        auto& hit = hits[(int)sideId];
+
+                        CHECK(hit.has_value() == expected);
+                        if (hit && expected)
+                            CHECK(std::abs(*hit - dist) <= DIST_TOLERANCE * std::max(1.0f, dist));
+                    }
+                }
+            }
+        }
+    }
+
+    template <class TFn>
+    double TimeMs(TFn&& fn) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void Benchmark() {
+        constexpr int PACKETS = 4'096;
+        constexpr int RAYS = 1'000;
+        Random random;
+
+        List<Triangle> tris(PACKETS * TrianglePacket::SIZE);
+        for (auto& tri : tris)
+            tri = { random.Point(), random.Point(), random.Point() };
+
+        List<TrianglePacket> packets;
+        for (int i = 0; i < PACKETS; i++)
+            packets.push_back(MakePacket({ &tris[i * TrianglePacket::SIZE], TrianglePacket::SIZE }));
+
+        List<Ray> rays(RAYS);
+        for (auto& ray : rays)
+            ray = random.NextRay();
+
+        // Accumulate the hits so the loops can't be optimized out and both paths can be compared
+        uint scalarHits = 0, packetHits = 0;
+
+        auto scalarMs = TimeMs([&] {
+            for (auto& ray : rays)
+                for (auto& tri : tris)
+                    scalarHits += IntersectScalar(ray, tri, FLT_MAX).has_value();
+        });
+
+        auto packetMs = TimeMs([&] {
+            for (auto& ray : rays)
+                for (auto& packet : packets)
+                    packetHits += std::popcount(IntersectPacket(ray, packet));
+        });
+
+        CHECK(scalarHits == packetHits);
+        auto tests = (double)tris.size() * rays.size();
+        fmt::print("Ray triangle tests: {:.0f}\n", tests);
+        fmt::print("Scalar: {:.1f} ms ({:.2f} ns per triangle)\n", scalarMs, scalarMs * 1e6 / tests);
+        fmt::print("Packet: {:.1f} ms ({:.2f} ns per triangle)\n", packetMs, packetMs * 1e6 / tests);
+        fmt::print("Speedup: {:.2f}x\n", scalarMs / packetMs);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    TestEmptyPacket();
+    TestHitsAndCulling();
+    TestDegenerateTriangles();
+    TestRandomTriangles();
+    TestIntersectSides();
+
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--benchmark")
+            Benchmark();
+    }
+
+    if (Failures > 0) {
+        fmt::print("{} checks failed\n", Failures);
+        return 1;
+    }
+
+    fmt::print("All checks passed\n");
+    return 0;
+}
\ No newline at end of file
@@ -16,7 +16,8 @@ using namespace Inferno;
 using namespace Inferno::Editor;
 
 void DumpD3VClips() {
-    for (auto& vclip : Resources::VClips) {
+    for (int id = 0; id < Resources::GetOutrageVClipCount(); id++) {
+        auto& vclip = Resources::GetOutrageVClip(id);
         fmt::print("v: {} FrameTime: {}s Pingpong: {}\n", vclip.Version, vclip.FrameTime, vclip.PingPong);
         for (auto& frame : vclip.Frames) {
             fmt::print("    {} : {} x {}\n", frame.Name, frame.Width, frame.Height);
@@ -108,6 +109,7 @@ void FireTestWeapon(Level& level, const Object& obj, int gun, int id) {
     sound.Resource = Resources::GetSoundResource(weapon.FlashSound);
     sound.Source = ObjID(0);
     sound.Volume = 0.35f;
+    sound.Priority = Sound::PRIORITY_PLAYER_WEAPON;
     Sound::Play(sound);
 
     Render::LoadTextureDynamic(weapon.WeaponVClip);
@@ -186,6 +188,8 @@ void Application::Update() {
         alpha = float(accumulator / dt);
     }
 
+    Sound::UpdateOcclusion(Game::Level, Render::Camera.Position);
+
     // todo: only update particles if game is not paused
     Render::UpdateParticles(Render::FrameTime);
     Editor::Update();
@@ -194,6 +198,9 @@ void Application::Update() {
     if (!Settings::Inferno.ScreenshotMode) _editorUI.OnRender();
     g_ImGuiBatch->EndFrame();
 
+    // Coalesce the level changes made during the frame before the mesh is rebuilt
+    Editor::Events::PublishLevelChanges();
+
     PIXEndEvent();
 
     Render::Present(alpha);
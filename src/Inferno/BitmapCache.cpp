@@ -76,7 +76,7 @@ namespace Inferno {
         for (auto& tex : textures) {
             if (tex.VClip >= 0) {
                 // Load each frame in the animation
-                auto& vclip = Resources::VClips[tex.VClip];
+                auto& vclip = Resources::GetOutrageVClip(tex.VClip);
                 if (tex.FrameHandles.size() != vclip.Frames.size())
                     tex.FrameHandles.resize(vclip.Frames.size(), MaterialHandle::None);
 
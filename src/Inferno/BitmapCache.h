@@ -18,7 +18,7 @@ namespace Inferno {
         float FrameTime = 1;
         bool Used = false;
         bool PingPong = false;
-        int VClip = -1; // index to Resources::VClips
+        int VClip = -1; // index to Resources::GetOutrageVClip()
 
         MaterialHandle GetFrame(int offset, float time) const {
             auto frames = (int)FrameHandles.size();
@@ -175,11 +175,8 @@ namespace Inferno {
                     return i; // Already loaded
             }
 
-            for (auto& tex : Resources::GameTable.Textures) {
-                if (String::InvariantEquals(tex.Name, name)) {
-                    return AllocTextureInfo({ tex });
-                }
-            }
+            if (auto tex = Resources::GameTable.FindTexture(name))
+                return AllocTextureInfo({ *tex });
 
             return -1;
         }
@@ -192,10 +189,8 @@ namespace Inferno {
                     return i; // Already exists
             }
 
-            for (auto& tex : Resources::GameTable.Textures) {
-                if (String::InvariantEquals(tex.FileName, fileName))
-                    return AllocTextureInfo({ tex });
-            }
+            if (auto tex = Resources::GameTable.FindTextureByFileName(fileName))
+                return AllocTextureInfo({ *tex });
 
             if (auto id = ResolveVClip(fileName); id != -1)
                 return id;
@@ -203,6 +198,38 @@ namespace Inferno {
             return -1;
         }
 
+        // Resolves several file names with a single pass over the existing textures.
+        // Returns -1 for names that weren't found. Used by D3 models.
+        List<int> ResolveFileNames(span<const string> fileNames) {
+            Dictionary<string, int> existing;
+            for (int i = 0; i < _textures.size(); i++)
+                existing.try_emplace(String::ToLower(_textures[i].FileName), i);
+
+            List<int> handles;
+            handles.reserve(fileNames.size());
+
+            for (auto& fileName : fileNames) {
+                auto key = String::ToLower(fileName);
+                if (auto match = existing.find(key); match != existing.end()) {
+                    handles.push_back(match->second);
+                    continue;
+                }
+
+                int id = -1;
+                if (auto tex = Resources::GameTable.FindTextureByFileName(fileName))
+                    id = AllocTextureInfo({ *tex });
+                else
+                    id = ResolveVClip(fileName);
+
+                if (id != -1)
+                    existing[key] = id;
+
+                handles.push_back(id);
+            }
+
+            return handles;
+        }
+
         const RuntimeTextureInfo& GetTextureInfo(int handle) {
             if (Seq::inRange(_textures, handle)) {
                 return _textures[handle];
@@ -243,6 +270,12 @@ namespace Inferno {
         int AllocTextureInfo(RuntimeTextureInfo&& ti) {
             int index = -1;
 
+            if (ti.Animated()) {
+                // Decode the frames in the background until the texture is uploaded
+                ti.VClip = Resources::FindOutrageVClip(ti.FileName);
+                Resources::RequestOutrageVClip(ti.VClip);
+            }
+
             // Find unused slot
             for (int i = 0; i < _textures.size(); i++) {
                 if (!_textures[i].Used) {
@@ -253,14 +286,6 @@ namespace Inferno {
                 }
             }
 
-            if (ti.Animated()) {
-                for (int id = 0; id < Resources::VClips.size(); id++) {
-                    auto& vclip = Resources::VClips[id];
-                    if (vclip.FileName == ti.FileName)
-                        ti.VClip = id;
-                }
-            }
-
             if (index == -1) {
                 // Add new slot
                 ti.Used = true;
@@ -272,20 +297,21 @@ namespace Inferno {
         }
 
 
-        int ResolveVClip(string frameName) {
-            for (int id = 0; id < Resources::VClips.size(); id++) {
-                auto& vclip = Resources::VClips[id];
-                for (auto& frame : vclip.Frames) {
-                    if (String::InvariantEquals(frame.Name, frameName)) {
-                        RuntimeTextureInfo ti;
-                        ti.FileName = frame.Name;
-                        ti.VClip = id;
-                        return AllocTextureInfo(std::move(ti));
-                    }
-                }
-            }
+        // Resolves a vclip by its file name, or by a frame of a vclip that was already decoded.
+        // Only the matching vclip is decoded.
+        int ResolveVClip(const string& name) {
+            auto id = Resources::FindOutrageVClip(name);
+            if (id == -1)
+                id = Resources::FindDecodedOutrageVClip(name);
 
-            return -1;
+            if (id == -1)
+                return -1;
+
+            Resources::RequestOutrageVClip(id);
+            RuntimeTextureInfo ti;
+            ti.FileName = name;
+            ti.VClip = id;
+            return AllocTextureInfo(std::move(ti));
         }
     };
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include "WorkerThread.h"
 
 template<class T>
@@ -38,4 +40,37 @@ public:
 
     const T& operator[](size_t index) const { return _data[index]; }
     T& operator[](int index) { return _data[index]; }
-};
\ No newline at end of file
+};
+
+// Lock-free handoff of data from a single producer thread to a single consumer thread.
+// The producer fills Back() and publishes it, the consumer picks up the most recent publish.
+// Neither side ever waits on the other.
+template<class T>
+class TripleBuffer {
+    static constexpr uint8_t INDEX_MASK = 0b011;
+    static constexpr uint8_t DIRTY = 0b100;
+
+    std::array<T, 3> _buffers{};
+    std::atomic<uint8_t> _ready = 1; // Index of the published buffer and a dirty flag
+    uint8_t _back = 0, _front = 2;
+public:
+    // Buffer owned by the producer
+    T& Back() { return _buffers[_back]; }
+
+    // Makes the back buffer visible to the consumer
+    void Publish() {
+        auto prev = _ready.exchange(uint8_t(_back | DIRTY), std::memory_order_acq_rel);
+        _back = prev & INDEX_MASK;
+    }
+
+    // Swaps in the most recently published buffer. Returns false if nothing new was published.
+    bool Update() {
+        if (!(_ready.load(std::memory_order_acquire) & DIRTY)) return false;
+        auto prev = _ready.exchange(_front, std::memory_order_acq_rel);
+        _front = prev & INDEX_MASK;
+        return true;
+    }
+
+    // Buffer owned by the consumer
+    const T& Front() const { return _buffers[_front]; }
+};
@@ -209,7 +209,7 @@ namespace Inferno::Editor {
             }
         }
 
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
 
         // Weld internal connections
         for (auto& id : newIds)
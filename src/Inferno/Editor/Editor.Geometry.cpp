@@ -6,11 +6,33 @@
 #include "Editor.Texture.h"
 #include "Editor.Segment.h"
 #include "Editor.Object.h"
+#include "GeometryTracker.h"
 
 #include "vendor/OpenSimplexNoise.h"
 #include <random>
 
 namespace Inferno::Editor {
+    namespace {
+        GeometryTracker LevelGeometry;
+    }
+
+    void UpdateGeometricProps(Level& level) {
+        if (&level != &Game::Level) {
+            level.UpdateAllGeometricProps();
+            return;
+        }
+
+        auto count = (int64)LevelGeometry.Update(level);
+        if (count > 0) InvalidateSegmentBounds();
+        Metrics::GeometryUpdates = count;
+        Metrics::TotalGeometryUpdates += count;
+    }
+
+    void ResetGeometricProps() {
+        LevelGeometry.Capture(Game::Level);
+        InvalidateSegmentBounds();
+    }
+
     using Input::SelectionState;
 
     short GetPairedEdge(Level& level, Tag tag, uint16 point) {
@@ -430,7 +452,7 @@ namespace Inferno::Editor {
         }
 
         TransformContainedObjects(level, gizmo);
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
     }
 
     void TransformObjects(Level& level, const TransformGizmo& gizmo) {
@@ -443,7 +465,7 @@ namespace Inferno::Editor {
                     level.SecretReturnOrientation = obj->Rotation;
 
                 if (!PointInSegment(level, obj->Segment, obj->Position)) {
-                    auto id = FindContainingSegment(level, obj->Position);
+                    auto id = FindContainingSegment(level, obj->Position, obj->Segment);
                     // Leave the last good ID if nothing contains the object
                     if (id != SegID::None) obj->Segment = id;
                 }
@@ -491,7 +513,7 @@ namespace Inferno::Editor {
             vert.z = std::round(vert.z / snap) * snap;
         }
 
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
     }
 
     void Commands::SnapToGrid() {
@@ -538,7 +560,7 @@ namespace Inferno::Editor {
             }
         }
 
-        Game::Level.UpdateAllGeometricProps();
+        UpdateGeometricProps(Game::Level);
         Events::LevelChanged();
         return "Make Coplanar";
     }
@@ -613,7 +635,7 @@ namespace Inferno::Editor {
             return {};
 
         Editor::Marked.Points.clear(); // Detaching points invalidates marks
-        Game::Level.UpdateAllGeometricProps();
+        UpdateGeometricProps(Game::Level);
         Events::LevelChanged();
         return "Detach Points";
     }
@@ -642,7 +664,7 @@ namespace Inferno::Editor {
                 *v = average;
         }
 
-        Game::Level.UpdateAllGeometricProps();
+        UpdateGeometricProps(Game::Level);
         Events::LevelChanged();
         return "Average Points";
     }
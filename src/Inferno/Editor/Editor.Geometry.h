@@ -10,6 +10,17 @@ namespace Inferno::Editor {
     // Returns 0 if not found.
     short GetPairedEdge(Level&, Tag, uint16 point);
 
+    namespace Metrics {
+        inline int64 GeometryUpdates = 0; // Segments refreshed by the last geometry update
+        inline int64 TotalGeometryUpdates = 0;
+    }
+
+    // Updates the normals, centers and split types of segments whose vertices changed since the last update.
+    // Refreshes every segment for levels other than the loaded one.
+    void UpdateGeometricProps(Level&);
+    // Records the loaded level geometry as up to date
+    void ResetGeometricProps();
+
     void DeleteSegment(Level&, SegID);
     void DeleteVertex(Level&, PointID);
 
@@ -13,6 +13,18 @@
 
 namespace Inferno::Editor {
     constexpr auto METADATA_EXTENSION = "ied"; // inferno engine data
+    constexpr auto LIGHTING_CACHE_EXTENSION = "ilc"; // inferno lighting cache
+
+    // Lighting caches are stored next to the level file.
+    // Levels in a HOG use the HOG name followed by the level name, so the cache isn't packed into the mission.
+    filesystem::path GetLightingCachePath(filesystem::path file, const string& levelName = {}) {
+        auto name = file.stem().string();
+        if (!levelName.empty())
+            name += "." + String::NameWithoutExtension(levelName);
+
+        file.replace_filename(name + "." + LIGHTING_CACHE_EXTENSION);
+        return file;
+    }
 
     size_t SaveLevel(Level& level, StreamWriter& writer) {
         if (level.Walls.size() >= (int)WallID::Max)
@@ -65,6 +77,9 @@ namespace Inferno::Editor {
         SaveLevelMetadata(level, metadata);
         SetStatusMessage(L"Saved level to {}", path.wstring());
 
+        if (!autosave)
+            WriteLightingCache(GetLightingCachePath(path));
+
         // Save custom textures
         if (Resources::CustomTextures.Any()) {
             auto ext = level.IsDescent1() ? ".dtx" : ".pog";
@@ -117,6 +132,7 @@ namespace Inferno::Editor {
 
         Game::UnloadMission();
         Game::LoadLevel(std::move(level));
+        ReadLightingCache(GetLightingCachePath(path));
         SetStatusMessage("Loaded level {}", path.filename().string());
     }
 
@@ -176,7 +192,7 @@ namespace Inferno::Editor {
     }
 
     // Writes a HOG file and updates the level
-    void WriteHog(Level& level, HogFile& mission, filesystem::path path) {
+    void WriteHog(Level& level, HogFile& mission, filesystem::path path, bool autosave = false) {
         filesystem::path tempPath = path;
         tempPath.replace_extension(".tmp");
 
@@ -245,9 +261,131 @@ namespace Inferno::Editor {
         BackupFile(path);
         filesystem::remove(path); // Remove existing
         filesystem::rename(tempPath, path); // Rename temp to destination
+
+        if (!autosave)
+            WriteLightingCache(GetLightingCachePath(path, level.FileName));
+
         fmt::print("\n");
     }
 
+    void RelightMission(const filesystem::path& path, const LightSettings& settings) {
+        auto start = std::chrono::steady_clock::now();
+        Game::LoadMission(path);
+        auto& mission = *Game::Mission;
+
+        struct RelightJob {
+            Inferno::Level Level;
+            LightingTextureTable Textures;
+            LightingStats Stats;
+            string Error;
+        };
+
+        // The game data depends on the level, so read the textures for each level before lighting them in parallel
+        List<RelightJob> jobs;
+        for (auto& entry : mission.GetLevels()) {
+            RelightJob job;
+
+            try {
+                job.Level = Resources::ReadLevel(entry.Name);
+                auto metadata = mission.TryReadEntry(String::NameWithoutExtension(entry.Name) + "." + METADATA_EXTENSION);
+                if (!metadata.empty())
+                    LoadLevelMetadata(job.Level, string((char*)metadata.data(), metadata.size()));
+
+                Resources::LoadLevel(job.Level);
+                if (!Resources::HasGameData())
+                    throw Exception("Game data not found");
+
+                job.Textures = CreateLightingTextureTable();
+            }
+            catch (const std::exception& e) {
+                job.Level.FileName = entry.Name;
+                job.Error = e.what();
+            }
+
+            jobs.push_back(std::move(job));
+        }
+
+        auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        auto workers = std::clamp((uint)jobs.size(), 1u, hardwareThreads);
+        auto threadsPerLevel = std::max(hardwareThreads / workers, 1u); // Spare threads go to each level
+        fmt::print("Lighting {} levels using {} threads\n", jobs.size(), hardwareThreads);
+
+        std::atomic<size_t> next = 0;
+        List<std::thread> threads;
+
+        for (uint i = 0; i < workers; i++) {
+            threads.emplace_back([&] {
+                for (auto index = next++; index < jobs.size(); index = next++) {
+                    auto& job = jobs[index];
+                    if (!job.Error.empty()) continue;
+
+                    try {
+                        job.Stats = LightLevel(job.Level, job.Textures, settings, threadsPerLevel);
+                    }
+                    catch (const std::exception& e) {
+                        job.Error = e.what();
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        fmt::print("\n{:<13} {:>7} {:>10} {:>14} {:>12} {:>12}\n", "Level", "Lights", "Time (s)", "Rays cast", "Ray hits", "Cache hits");
+
+        for (auto& job : jobs) {
+            if (!job.Error.empty()) {
+                fmt::print("{:<13} Skipped: {}\n", job.Level.FileName, job.Error);
+                continue;
+            }
+
+            auto& stats = job.Stats;
+            fmt::print("{:<13} {:>7} {:>10.2f} {:>14} {:>12} {:>12}\n",
+                       job.Level.FileName, stats.Lights, stats.Time / 1'000'000.0, stats.RaysCast, stats.RayHits, stats.CacheHits);
+
+            if (stats.DynamicLightLimit)
+                fmt::print("    Maximum dynamic lights reached. Some lights will not work as expected.\n");
+
+            if (stats.LightDeltaLimit)
+                fmt::print("    Maximum light deltas reached. Some lights will not work as expected.\n");
+        }
+
+        // Replace the lit levels and copy everything else
+        filesystem::path tempPath = mission.Path;
+        tempPath.replace_extension(".tmp");
+
+        {
+            HogWriter writer(tempPath);
+
+            for (auto& entry : mission.Entries) {
+                auto job = ranges::find_if(jobs, [&entry](const RelightJob& j) { return j.Level.FileName == entry.Name; });
+
+                if (job != jobs.end() && job->Error.empty()) {
+                    try {
+                        // Save the same way as the editor so the level is fixed up before writing
+                        auto data = SerializeToMemory([&job](StreamWriter& w) { return SaveLevel(job->Level, w); });
+                        writer.WriteEntry(entry.Name, data);
+                        continue;
+                    }
+                    catch (const std::exception& e) {
+                        fmt::print("{:<13} Not saved: {}\n", entry.Name, e.what());
+                    }
+                }
+
+                auto data = mission.ReadEntry(entry);
+                writer.WriteEntry(entry.Name, data);
+            }
+        }
+
+        BackupFile(mission.Path);
+        filesystem::remove(mission.Path);
+        filesystem::rename(tempPath, mission.Path);
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fmt::print("\nWrote {} in {:.2f}s\n", mission.Path.string(), elapsed);
+    }
+
     void LoadFile(filesystem::path path) {
         try {
             auto version = FileVersionFromHeader(path);
@@ -294,6 +432,9 @@ namespace Inferno::Editor {
             }
 
             Game::LoadLevel(std::move(level));
+
+            if (Game::Mission)
+                ReadLightingCache(GetLightingCachePath(Game::Mission->Path, name));
         }
         catch (const std::exception& e) {
             ShowErrorMessage(e);
@@ -569,7 +710,7 @@ namespace Inferno::Editor {
                 SPDLOG_INFO(L"Autosaving backup to {}", backupPath);
 
                 if (Game::Mission) {
-                    WriteHog(Game::Level, *Game::Mission, backupPath);
+                    WriteHog(Game::Level, *Game::Mission, backupPath, true);
                 }
                 else {
                     SaveLevelToPath(Game::Level, backupPath, true);
@@ -3,6 +3,7 @@
 #include "Level.h"
 #include "Command.h"
 #include "HogFile.h"
+#include "Settings.h"
 
 namespace Inferno::Editor {
     // Creates a backup of a file using the provided extension
@@ -13,6 +14,9 @@ namespace Inferno::Editor {
     void ResetAutosaveTimer();
     void WritePlaytestLevel(filesystem::path missionFolder, Level& level, HogFile* mission);
 
+    // Relights every level in a mission in parallel and writes them back to the HOG. Prints the time and counters for each level.
+    void RelightMission(const filesystem::path& path, const LightSettings& settings);
+
     namespace Commands {
         extern Command ConvertToD2, ConvertToVertigo;
         extern Command NewLevel, Open, Save, SaveAs;
@@ -7,6 +7,11 @@
 #include "Editor.h"
 #include "ScopedTimer.h"
 #include "WindowsDialogs.h"
+#include "VisibilityCache.h"
+#include "TrianglePacket.h"
+#include "Streams.h"
+#include <barrier>
+#include <execution>
 
 namespace Inferno::Editor {
     constexpr float PLANE_TOLERANCE = -0.01f;
@@ -117,28 +122,64 @@ namespace Inferno::Editor {
         }
     };
 
+    // Progress shared between the lighting threads
+    struct LightingCounters {
+        std::atomic<bool> Cancelled = false;
+        std::atomic<int> LightsDone = 0; // Lights finished in the current pass
+        std::atomic<int> PassesDone = 0;
+        std::atomic<uint64> RaysCast = 0;
+    };
+
+    // Triangles that block light in each segment, packed for testing several at once
+    struct LightOccluders {
+        List<TrianglePacket> Packets;
+        List<uint32> Offsets; // Packets for a segment are in [Offsets[seg], Offsets[seg + 1])
+
+        span<const TrianglePacket> GetPackets(SegID seg) const {
+            auto start = Offsets[(int)seg];
+            return span(Packets).subspan(start, Offsets[(int)seg + 1] - start);
+        }
+    };
+
     // Self-contained unit of work
     struct LightContext {
         Dictionary<Tag, LightRayCast> RayCasts;
 
-        // Key is a combination of src seg, src vertex and dest vertex. Value indicates if dest is visible.
-        Dictionary<int64, bool> HitTests;
+        // Key is a combination of the src and dest sides and vertices. Value indicates if dest is occluded.
+        VisibilityCache HitTests;
+        // Results from the direct pass of all threads. Read only.
+        const VisibilityCache* SharedHitTests = nullptr;
 
         List<LightSource> Lights;
         LightSettings Settings;
+        const LightingTextureTable* Textures = nullptr;
+        const LightOccluders* Occluders = nullptr;
         std::thread Thread;
         int CastStats = 0;
         int HitStats = 0;
         uint64 CacheHits = 0;
         int Id = 0;
+        LightingCounters* Counters = nullptr;
 
         LightContext() {
-            HitTests.reserve(100'000);
+            HitTests.Reserve(100'000);
             RayCasts.reserve(50);
         }
 
         // Initial lighting pass from direct light sources
         void EmitDirectLight(Level& level);
+
+        // Casts the light from the previous pass back into the level
+        void EmitBounce(Level& level, int bounce);
+
+        bool IsCancelled() const { return Counters && Counters->Cancelled; }
+
+        // Records a finished light for progress reporting
+        void ReportProgress(int castsBefore) const {
+            if (!Counters) return;
+            Counters->LightsDone++;
+            Counters->RaysCast += CastStats - castsBefore;
+        }
     };
 
     // checks that there's enough light to bother saving. Prevents wasteful raycasts.
@@ -207,7 +248,7 @@ namespace Inferno::Editor {
     }
 
     // Returns true if light can pass through this side. Depends on the connections, texture and wall type if present.
-    bool LightPassesThroughSide(const Level& level, const Segment& seg, SideID sideId) {
+    bool LightPassesThroughSide(const Level& level, const LightingTextureTable& textures, const Segment& seg, SideID sideId) {
         auto& side = seg.GetSide(sideId);
         auto connection = seg.GetConnection(sideId);
         if (connection == SegID::None || connection == SegID::Exit) return false; // solid wall
@@ -223,10 +264,8 @@ namespace Inferno::Editor {
                 return true;
 
             case WallType::Door:
-                if (side.HasOverlay()) {
-                    auto& tmap2 = Resources::GetTextureInfo(side.TMap2);
-                    return tmap2.SuperTransparent;
-                }
+                if (side.HasOverlay())
+                    return textures.Get(side.TMap2).SuperTransparent;
                 return false;
 
             case WallType::WallTrigger: // triggers are always on a solid wall
@@ -235,13 +274,10 @@ namespace Inferno::Editor {
             default:
             {
                 // Check if the textures are transparent
-                auto& tmap1 = Resources::GetTextureInfo(side.TMap);
-                bool transparent = tmap1.Transparent;
+                bool transparent = textures.Get(side.TMap).Transparent;
 
-                if (side.HasOverlay()) {
-                    auto& tmap2 = Resources::GetTextureInfo(side.TMap2);
-                    transparent |= tmap2.SuperTransparent;
-                }
+                if (side.HasOverlay())
+                    transparent |= textures.Get(side.TMap2).SuperTransparent;
 
                 return transparent;
             }
@@ -265,22 +301,44 @@ namespace Inferno::Editor {
         }
     }
 
+    // Reads the texture properties used by the solver from the loaded game data
+    LightingTexture GetLightingTexture(LevelTexID id) {
+        auto& info = Resources::GetTextureInfo(id);
+
+        return {
+            .Lighting = Resources::GetLevelTextureInfo(id).Lighting,
+            .AverageColor = info.AverageColor,
+            .Transparent = info.Transparent,
+            .SuperTransparent = info.SuperTransparent,
+            .Destroyable = Resources::GetDestroyedTexture(id) > LevelTexID::Unset
+        };
+    }
+
+    LightingTextureTable CreateLightingTextureTable() {
+        LightingTextureTable table;
+        table.Default = GetLightingTexture(LevelTexID::None);
+        table.Textures.reserve(Resources::GameData.TexInfo.size());
+
+        for (int i = 0; i < Resources::GameData.TexInfo.size(); i++)
+            table.Textures.push_back(GetLightingTexture(LevelTexID(i)));
+
+        return table;
+    }
+
     // Returns the light contribution from both textures on this side
-    Color GetLightColor(const SegmentSide& side, bool enableColor) {
+    Color GetLightColor(const SegmentSide& side, const LightingTexture& tmap1, const LightingTexture& tmap2, bool enableColor) {
         if (side.LightOverride) return *side.LightOverride;
 
-        auto& tmap1 = Resources::GetLevelTextureInfo(side.TMap);
-        auto& tmap2 = Resources::GetLevelTextureInfo(side.TMap2);
         auto luminosity = tmap1.Lighting + tmap2.Lighting;
 
         if (enableColor) {
             Color color;
 
             if (tmap1.Lighting > 0)
-                color += Resources::GetTextureInfo(side.TMap).AverageColor;
+                color += tmap1.AverageColor;
 
             if (tmap2.Lighting > 0)
-                color += Resources::GetTextureInfo(side.TMap2).AverageColor;
+                color += tmap2.AverageColor;
 
             return color * luminosity;
         }
@@ -289,9 +347,17 @@ namespace Inferno::Editor {
         }
     }
 
+    Color GetLightColor(const SegmentSide& side, const LightingTextureTable& textures, bool enableColor) {
+        return GetLightColor(side, textures.Get(side.TMap), textures.Get(side.TMap2), enableColor);
+    }
+
+    Color GetLightColor(const SegmentSide& side, bool enableColor) {
+        return GetLightColor(side, GetLightingTexture(side.TMap), GetLightingTexture(side.TMap2), enableColor);
+    }
+
     // Returns segments that are within range and visible from the source surface.
     // Culls segments that are behind the plane of src.
-    Set<SegID> GetSegmentsInRange(Level& level, Tag src, float distanceThreshold) {
+    Set<SegID> GetSegmentsInRange(Level& level, const LightingTextureTable& textures, Tag src, float distanceThreshold) {
         auto srcFace = Face::FromSide(level, src);
 
         Set<SegID> segmentsToLight;
@@ -307,7 +373,7 @@ namespace Inferno::Editor {
             segmentsToLight.insert(segId);
 
             for (auto& sideId : SideIDs) {
-                if (!LightPassesThroughSide(level, seg, sideId)) continue;
+                if (!LightPassesThroughSide(level, textures, seg, sideId)) continue;
                 auto connection = seg.GetConnection(sideId);
                 if (segmentsToLight.contains(connection)) continue; // Don't add visited connections
 
@@ -344,37 +410,49 @@ namespace Inferno::Editor {
         return segmentsToLight;
     }
 
-    // Returns true if the ray intersects any faces of the segment
-    bool HitTestRay(Level& level, const Set<SegID>& segments, const Ray& ray, float minDist, LightContext& ctx) {
-        for (auto& segId : segments) {
-            const auto& seg = level.GetSegment(segId);
+    LightOccluders CreateLightOccluders(const Level& level, const LightingTextureTable& textures) {
+        LightOccluders occluders;
+        occluders.Offsets.reserve(level.Segments.size() + 1);
+        auto& verts = level.Vertices;
+
+        for (auto& seg : level.Segments) {
+            occluders.Offsets.push_back((uint32)occluders.Packets.size());
+            TrianglePacket packet;
 
             for (auto& sideId : SideIDs) {
-                if (LightPassesThroughSide(level, seg, sideId)) continue; // ignore sides that light passes through
+                if (LightPassesThroughSide(level, textures, seg, sideId)) continue; // ignore sides that light passes through
                 const auto& side = seg.GetSide(sideId);
-                bool sideIsWall = side.Wall != WallID::None;
-                if (sideIsWall && side.Normals[0].Dot(ray.direction) > 0) continue; // skip walls pointing the same direction (allows passing through one-way walls)
+                // skip walls pointing the same direction as the ray (allows passing through one-way walls)
+                auto cullNormal = side.Wall != WallID::None ? side.Normals[0] : Vector3::Zero;
 
                 auto ri = side.GetRenderIndices();
                 auto indices = seg.GetVertexIndices(sideId);
-                float dist{};
-
-                ctx.CastStats++;
-                if (ray.Intersects(level.Vertices[indices[ri[0]]],
-                                   level.Vertices[indices[ri[1]]],
-                                   level.Vertices[indices[ri[2]]],
-                                   dist)
-                    && dist < minDist) {
-                    ctx.HitStats++;
-                    return true;
+
+                for (int i = 0; i < 6; i += 3) {
+                    packet.Add(verts[indices[ri[i]]], verts[indices[ri[i + 1]]], verts[indices[ri[i + 2]]], cullNormal);
+
+                    if (packet.IsFull()) {
+                        occluders.Packets.push_back(packet);
+                        packet = {};
+                    }
                 }
+            }
 
-                ctx.CastStats++;
-                if (ray.Intersects(level.Vertices[indices[ri[3]]],
-                                   level.Vertices[indices[ri[4]]],
-                                   level.Vertices[indices[ri[5]]],
-                                   dist)
-                    && dist < minDist) {
+            if (packet.Count > 0)
+                occluders.Packets.push_back(packet);
+        }
+
+        occluders.Offsets.push_back((uint32)occluders.Packets.size());
+        return occluders;
+    }
+
+    // Returns true if the ray intersects any faces of the segments that block light
+    bool HitTestRay(const Set<SegID>& segments, const Ray& ray, float minDist, LightContext& ctx) {
+        for (auto& segId : segments) {
+            for (auto& packet : ctx.Occluders->GetPackets(segId)) {
+                ctx.CastStats += packet.Count;
+
+                if (IntersectPacket(ray, packet, minDist)) {
                     ctx.HitStats++;
                     return true;
                 }
@@ -384,11 +462,21 @@ namespace Inferno::Editor {
         return false;
     }
 
+    // Packs the src and dest sides and the index of the light and sample vertex on each side into 42 bits.
+    // The sample positions only depend on the side and vertex index, so the vertex ids aren't needed.
+    constexpr uint64 PackHitTestId(Tag src, int lightIndex, Tag dest, int destIndex) {
+        return (uint64)(uint16)src.Segment << 26 | (uint64)src.Side << 23 | (uint64)lightIndex << 21 |
+            (uint64)(uint16)dest.Segment << 5 | (uint64)dest.Side << 2 | (uint64)destIndex;
+    }
+
+    constexpr Tag UnpackHitTestSource(uint64 id) {
+        return { SegID((int16)(uint16)(id >> 26)), SideID((id >> 23) & 0b111) };
+    }
+
     // Returns true if geometry blocks the path between src point and light. Caches results.
-    bool HitTest(Level& level,
-                 const Set<SegID>& segments,
-                 PointID destPoint,
-                 PointID lightPoint,
+    bool HitTest(const Set<SegID>& segments,
+                 int destIndex,
+                 int lightIndex,
                  const Vector3& lightPos,
                  const Vector3& samplePos,
                  Tag src,
@@ -396,35 +484,30 @@ namespace Inferno::Editor {
                  LightContext& ctx) {
         if (src.Segment == dest.Segment) return false;
 
-        if ((int)src.Segment > 32767 || (int)dest.Segment > 32767 || (int)destPoint > 46339 || (int)lightPoint > 46339)
-            throw Exception("Lighting only supports up to 32767 segments and 46339 verts");
+        auto id = PackHitTestId(src, lightIndex, dest, destIndex);
 
-        auto packedSegId = SzudzikPairing((uint16)src.Segment, (uint16)dest.Segment); // limited to 32767 (28 bit result)
-        auto packedPointId = SzudzikPairing(destPoint, lightPoint); // limited to 46339 (30 bit result)
-        uint64 id = (uint64)dest.Side << (28 + 30 + 3) | (uint64)src.Side << (28 + 30) | (uint64)packedPointId << 28 | (uint64)packedSegId;
+        if (ctx.SharedHitTests) {
+            if (auto result = ctx.SharedHitTests->Find(id)) {
+                ctx.CacheHits++;
+                return *result;
+            }
+        }
 
-        //// Note that this packing breaks if there are more than 8191 segments in a level
-        //uint16 packedSrc = (uint16)src.Segment | ((uint16)src.Side << (16 - 3)); // pack side into the 3 high bits
-        //uint16 packedDest = (uint16)dest.Segment | ((uint16)dest.Side << (16 - 3)); // pack side into the 3 high bits
-        //uint64 id = (uint64)packedDest << 48 | (uint64)packedSrc << 32 | (uint64)destPoint << 16 | lightPoint;
+        if (auto result = ctx.HitTests.Find(id)) {
+            ctx.CacheHits++;
+            return *result;
+        }
 
-        if (!ctx.HitTests.contains(id)) {
-            auto dir = samplePos - lightPos;
-            float minDist = dir.Length() - 0.01f; // minimum distance the light must travel. hitting something before this means a wall was in the way.
-            dir.Normalize();
+        auto dir = samplePos - lightPos;
+        float minDist = dir.Length() - 0.01f; // minimum distance the light must travel. hitting something before this means a wall was in the way.
+        dir.Normalize();
 
-            bool result = false;
-            // Direction length can be zero if segment has zero volume, assume it misses
-            Ray ray(lightPos, dir);
-            result = dir.Length() != 0 ? HitTestRay(level, segments, ray, minDist, ctx) : false;
+        // Direction length can be zero if segment has zero volume, assume it misses
+        Ray ray(lightPos, dir);
+        bool result = dir.Length() != 0 ? HitTestRay(segments, ray, minDist, ctx) : false;
 
-            ctx.HitTests[id] = result;
-            return result;
-        }
-        else {
-            ctx.CacheHits++;
-            return ctx.HitTests[id];
-        }
+        ctx.HitTests.Insert(id, result);
+        return result;
     }
 
     void LightSegments(Level& level,
@@ -475,7 +558,7 @@ namespace Inferno::Editor {
                         if (attenuation <= 0) return Color();
 
                         if (cast.Source->EnableOcclusion &&
-                            HitTest(level, segmentsToLight, destVertIds[vertIndex], lightVertIds[lightIndex], lightSamples[lightIndex], destSamples[vertIndex], src, dest, ctx))
+                            HitTest(segmentsToLight, vertIndex, lightIndex, lightSamples[lightIndex], destSamples[vertIndex], src, dest, ctx))
                             return Color();
 
                         auto multiplier = bouncePass ? ctx.Settings.Reflectance : ctx.Settings.Multiplier;
@@ -550,13 +633,14 @@ namespace Inferno::Editor {
         cast.Pass = {};
 
         for (const auto& [src, lightColors] : prevPass) {
+            if (ctx.IsCancelled()) break;
             auto [srcSeg, srcSide] = level.GetSegmentAndSide(src);
 
             // don't emit from open connections (from accurate volumes setting)
             if (srcSeg.SideHasConnection(src.Side) && !srcSeg.SideIsWall(src.Side)) continue;
 
-            Set<SegID> segmentsToLight = GetSegmentsInRange(level, src, ctx.Settings.DistanceThreshold);
-            Color tmapColor = Resources::GetTextureInfo(srcSide.TMap).AverageColor;
+            Set<SegID> segmentsToLight = GetSegmentsInRange(level, *ctx.Textures, src, ctx.Settings.DistanceThreshold);
+            Color tmapColor = ctx.Textures->Get(srcSide.TMap).AverageColor;
             tmapColor.AdjustSaturation(2); // boost saturation to look nicer
             ScaleColor2(tmapColor, 1); // 100% brightness
             SideLighting adjColors = lightColors;
@@ -570,7 +654,7 @@ namespace Inferno::Editor {
     }
 
     LightRayCast& CastDirectLight(Level& level, const LightSource& light, const LightSettings& settings, LightContext& ctx) {
-        Set<SegID> segmentsToLight = GetSegmentsInRange(level, light.Tag, settings.DistanceThreshold);
+        Set<SegID> segmentsToLight = GetSegmentsInRange(level, *ctx.Textures, light.Tag, settings.DistanceThreshold);
 
         auto& cast = ctx.RayCasts[light.Tag];
         cast.Source = &light;
@@ -627,7 +711,7 @@ namespace Inferno::Editor {
     }
 
     // Gathers all light sources in the level
-    List<LightSource> GatherLightSources(Level& level, const LightSettings& settings) {
+    List<LightSource> GatherLightSources(Level& level, const LightingTextureTable& textures, const LightSettings& settings) {
         List<LightSource> sources;
 
         for (int i = 0; i < level.Segments.size(); i++) {
@@ -638,7 +722,7 @@ namespace Inferno::Editor {
                 if (seg.SideHasConnection(sideId) && !seg.SideIsWall(sideId)) continue; // open sides can't have lights
 
                 auto& side = seg.GetSide(sideId);
-                auto color = GetLightColor(side, settings.EnableColor);
+                auto color = GetLightColor(side, textures, settings.EnableColor);
                 if (!CheckMinLight(color)) continue;
 
                 Tag tag = { segId, sideId };
@@ -647,7 +731,7 @@ namespace Inferno::Editor {
                     .Tag = tag,
                     .Indices = seg.GetVertexIndices(sideId),
                     .Colors = { color, color, color, color },
-                    .IsDynamic = Resources::GetDestroyedTexture(side.TMap2) > LevelTexID::Unset || level.GetFlickeringLight(tag),
+                    .IsDynamic = textures.Get(side.TMap2).Destroyable || level.GetFlickeringLight(tag),
                     .Radius = side.LightRadiusOverride.value_or(settings.Radius),
                     .LightPlaneTolerance = side.LightPlaneOverride.value_or(settings.LightPlaneTolerance),
                     .EnableOcclusion = side.EnableOcclusion,
@@ -662,31 +746,62 @@ namespace Inferno::Editor {
 
     void LightContext::EmitDirectLight(Level& level) {
         for (auto& source : Lights) {
+            if (IsCancelled()) return;
+            auto casts = CastStats;
             auto& cast = CastDirectLight(level, source, Settings, *this);
             cast.AccumulatePass();
+            ReportProgress(casts);
         }
     }
 
-    // Calculates the volume light for all segments in the level based on surface lighting
-    void SetVolumeLight(Level& level, bool accurateVolumes) {
-        for (auto& seg : level.Segments) {
-            if (seg.LockVolumeLight) continue;
-            Color volume;
-
-            int contributingSides = 0;
-            // 6 sides with four color values
-            for (auto& sideId : SideIDs) {
-                if (!accurateVolumes && seg.SideHasConnection(sideId) && !seg.SideIsWall(sideId)) continue; // skip open sides unless accurate volumes enabled
-                auto& side = seg.GetSide(sideId);
-                for (auto& v : side.Light)
-                    volume += v;
-                contributingSides++;
-            }
+    void LightContext::EmitBounce(Level& level, int bounce) {
+        for (auto& light : RayCasts | views::values) {
+            if (IsCancelled()) return;
+            auto casts = CastStats;
+            auto& info = CastBounces(level, light, *this);
+            info.AccumulatePass(!(Settings.SkipFirstPass && bounce == 0));
+            ReportProgress(casts);
+        }
+    }
 
-            if (contributingSides == 0) continue;
-            seg.VolumeLight += volume * (1.0f / (contributingSides * 4));
-            seg.VolumeLight.A(1);
+    // Returns the ambient light plus the average surface lighting of the segment
+    Color GetVolumeLight(const Segment& seg, const Color& ambient, bool accurateVolumes) {
+        Color volume;
+        Color result = ambient;
+
+        int contributingSides = 0;
+        // 6 sides with four color values
+        for (auto& sideId : SideIDs) {
+            if (!accurateVolumes && seg.SideHasConnection(sideId) && !seg.SideIsWall(sideId)) continue; // skip open sides unless accurate volumes enabled
+            auto& side = seg.GetSide(sideId);
+            for (auto& v : side.Light)
+                volume += v;
+            contributingSides++;
         }
+
+        if (contributingSides > 0)
+            result += volume * (1.0f / (contributingSides * 4));
+
+        result.A(1);
+        return result;
+    }
+
+    // Calculates the volume light for all segments in the level based on surface lighting.
+    // Segments only read their own sides, so the result doesn't depend on the order they are evaluated in.
+    void SetVolumeLight(Level& level, const Color& ambient, bool accurateVolumes) {
+        std::for_each(std::execution::par, level.Segments.begin(), level.Segments.end(), [&](Segment& seg) {
+            if (!seg.LockVolumeLight)
+                seg.VolumeLight = GetVolumeLight(seg, ambient, accurateVolumes);
+        });
+    }
+
+    // Recalculates the volume light for segments whose surface lighting changed
+    void SetVolumeLight(Level& level, span<const SegID> segments, const Color& ambient, bool accurateVolumes) {
+        std::for_each(std::execution::par, segments.begin(), segments.end(), [&](SegID id) {
+            auto& seg = level.GetSegment(id);
+            if (!seg.LockVolumeLight)
+                seg.VolumeLight = GetVolumeLight(seg, ambient, accurateVolumes);
+        });
     }
 
     // Scales the brightness of values over 1 while retaining color
@@ -720,8 +835,8 @@ namespace Inferno::Editor {
     }
 
     // Sets the initial brightness for all geometry in the level
-    void SetAmbientLight(Color ambient) {
-        for (auto& seg : Game::Level.Segments) {
+    void SetAmbientLight(Level& level, Color ambient) {
+        for (auto& seg : level.Segments) {
             for (auto& side : seg.Sides) {
                 for (int i = 0; i < 4; i++) {
                     if (side.LockLight[i]) continue;
@@ -737,18 +852,20 @@ namespace Inferno::Editor {
         }
     }
 
-    // Generates the dynamic light table for destroyable and flickering lights
-    void SetDynamicLights(Level& level, const Dictionary<Tag, LightRayCast>& rayCasts) {
+    // Generates the dynamic light table for destroyable and flickering lights. Records reaching a limit in stats.
+    void SetDynamicLights(Level& level, const Dictionary<Tag, LightRayCast>& rayCasts, LightingStats& stats) {
         for (auto& [src, light] : rayCasts) {
             if (!light.Source->IsDynamic) continue;
 
             if (level.LightDeltaIndices.size() >= MaxDynamicLights) {
-                ShowWarningMessage(L"Maximum dynamic lights reached. Some lights will not work as expected.");
+                SPDLOG_WARN("Maximum dynamic lights reached");
+                stats.DynamicLightLimit = true;
                 return;
             }
 
             if (level.LightDeltas.size() + MaxDeltasPerLight > MaxLightDeltas) {
-                ShowWarningMessage(L"Maximum light deltas reached. Some lights will not work as expected.");
+                SPDLOG_WARN("Maximum light deltas reached");
+                stats.LightDeltaLimit = true;
                 return;
             }
 
@@ -875,138 +992,662 @@ namespace Inferno::Editor {
         return tree;
     }
 
-    // Lights the level geometry and volumes. Not thread safe (needs refactoring to not use globals).
-    void Commands::LightLevel(Level& level, const LightSettings& settings) {
+    // Assigns lights to contexts based on their spatial locality
+    List<LightContext> PartitionLights(Level& level, List<LightSource>& lights, size_t availThreads) {
+        auto bucketSize = (int)std::max(lights.size() / availThreads, size_t(1));
+
+        List<LightContext> threads(availThreads);
+        int bucketIndex = 0;
+
+        std::function<void(OctreeLeaf&)> addNodeLights = [&](const OctreeLeaf& leaf) {
+            if (bucketIndex >= threads.size()) {
+                // ran out of buckets, dump everything into 0
+                Seq::append(threads[0].Lights, leaf.Lights);
+            }
+            else if (leaf.Lights.size() <= bucketSize) {
+                // lights in this leaf fit into a bucket
+                Seq::append(threads[bucketIndex].Lights, leaf.Lights);
+                if (threads[bucketIndex].Lights.size() >= bucketSize)
+                    bucketIndex++;
+            }
+            else {
+                for (int i = 0; i < 8; i++) {
+                    if (leaf.Children[i]) {
+                        addNodeLights(*leaf.Children[i]);
+                    }
+                }
+            }
+        };
+
+        auto tree = CreateLightOctree(level, lights, bucketSize);
+        addNodeLights(tree);
+        Seq::sortBy(threads, [](const LightContext& a, const LightContext& b) {
+            return a.Lights.size() > b.Lights.size();
+        });
+
+        // Count the number of empty and filled threads
+        int emptyThreads = 0, filledThreads = 0;
+        for (auto& thread : threads) {
+            if (thread.Lights.empty())
+                emptyThreads++;
+            else
+                filledThreads++;
+        }
+
+        // Fill empty threads by splitting large buckets
+        for (int i = 0; i < emptyThreads; i++) {
+            auto& src = threads[i].Lights;
+            auto& dst = threads[filledThreads + i].Lights;
+            // move half of the lights to a new thread
+            auto len = src.size() / 2;
+            std::move(src.begin() + len, src.end(), std::back_inserter(dst));
+            src.resize(src.size() - dst.size());
+            //assert(originalLen == src.size() + dst.size());
+        }
+
+        // If single threaded, preallocate a single large buffer
+        if (availThreads == 1) {
+            threads[0].HitTests.Reserve(1'000'000);
+            threads[0].RayCasts = Dictionary<Tag, LightRayCast>{ 1000 };
+        }
+
+        return threads;
+    }
+
+    int GetLightingPasses(const LightSettings& settings) {
+        return 1 + std::clamp(settings.Bounces, 0, 10);
+    }
+
+    // Gathers the lights in the level and splits them between contexts that can be solved in parallel
+    List<LightContext> CreateLightContexts(Level& level, const LightingTextureTable& textures, const LightSettings& settings, uint threads) {
+        auto lights = GatherLightSources(level, textures, settings);
+
+        if (settings.CheckCoplanar)
+            ReduceCoplanarBrightness(level, lights);
+
+        auto contexts = PartitionLights(level, lights, std::max(threads, 1u));
+        std::erase_if(contexts, [](const LightContext& ctx) { return ctx.Lights.empty(); });
+
+        int id = 0;
+        for (auto& ctx : contexts) {
+            ctx.Settings = settings;
+            ctx.Textures = &textures;
+            ctx.Id = id++;
+        }
+
+        return contexts;
+    }
+
+    // Bounces cast from sides lit by other threads, so combine the direct pass results for every thread to read
+    void ShareHitTests(span<LightContext> contexts, VisibilityCache& shared) {
+        auto count = shared.Count();
+        for (auto& ctx : contexts)
+            count += ctx.HitTests.Count();
+
+        shared.Reserve(count);
+
+        for (auto& ctx : contexts) {
+            shared.Merge(ctx.HitTests);
+            ctx.HitTests.Clear();
+        }
+
+        SPDLOG_INFO("Shared {} hit tests using {} MB", shared.Count(), shared.MemoryUsage() / (1024 * 1024));
+    }
+
+    // Solves each context on its own thread and waits for them to finish. Rethrows the first error from a worker.
+    // The workers wait for each other after the direct pass and each bounce, then onPassFinished runs on one of them.
+    void RunLightContexts(Level& level, span<LightContext> contexts, int passes, LightingCounters& counters,
+                          VisibilityCache& sharedHitTests, const std::function<void()>& onPassFinished = {}) {
+        if (contexts.empty()) return;
+
+        auto occluders = CreateLightOccluders(level, *contexts[0].Textures);
+        std::exception_ptr error;
+        std::mutex errorLock;
+
+        // Runs while the other workers wait, so reading the accumulated light is safe
+        auto passFinished = [&]() noexcept {
+            if (counters.PassesDone++ == 0 && passes > 1)
+                ShareHitTests(contexts, sharedHitTests);
+
+            counters.LightsDone = 0;
+            if (!counters.Cancelled && onPassFinished) onPassFinished();
+        };
+
+        std::barrier sync((ptrdiff_t)contexts.size(), passFinished);
+
+        for (auto& ctx : contexts) {
+            ctx.Counters = &counters;
+            ctx.SharedHitTests = &sharedHitTests;
+            ctx.Occluders = &occluders;
+
+            // Accumulate radiosity bounces
+            ctx.Thread = std::thread([&, passes] {
+                SPDLOG_INFO("Dispatching thread {} with {} lights", ctx.Id, ctx.Lights.size());
+
+                for (int pass = 0; pass < passes; pass++) {
+                    try {
+                        if (pass == 0)
+                            ctx.EmitDirectLight(level);
+                        else
+                            ctx.EmitBounce(level, pass - 1);
+                    }
+                    catch (...) {
+                        std::scoped_lock lock(errorLock);
+                        if (!error) error = std::current_exception();
+                        counters.Cancelled = true;
+                    }
+
+                    // Every worker must arrive at each pass, even after cancelling
+                    sync.arrive_and_wait();
+                }
+
+                if (!ctx.Settings.EnableColor)
+                    DesaturateAccumulated(ctx.RayCasts);
+
+                SPDLOG_INFO("Thread {} finished. Lights: {} Cache size: {}", ctx.Id, ctx.Lights.size(), ctx.HitTests.Count());
+            });
+        }
+
+        for (auto& ctx : contexts) {
+            if (ctx.Thread.joinable())
+                ctx.Thread.join();
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // Replaces the lighting of the level with the results of the contexts
+    LightingStats MergeLightContexts(Level& level, span<const LightContext> contexts, const LightSettings& settings) {
+        LightingStats stats;
+        level.LightDeltaIndices.clear();
+        level.LightDeltas.clear();
+        SetAmbientLight(level, settings.Ambient);
+
+        auto maxValue = std::clamp(settings.MaxValue, 0.0f, 10.0f);
+        const Color max = { maxValue, maxValue, maxValue, 1 };
+
+        // Merge the results from each light
+        for (auto& ctx : contexts) {
+            // updating the level must be done in serial
+            SetSideLighting(level, ctx.RayCasts, max, settings.EnableColor);
+            if (settings.EnableColor)
+                ClampColorBrightness(level, settings.MaxValue);
+
+            SetDynamicLights(level, ctx.RayCasts, stats);
+            stats.Lights += (int)ctx.Lights.size();
+            stats.CacheHits += ctx.CacheHits;
+            stats.RayHits += ctx.HitStats;
+            stats.RaysCast += ctx.CastStats;
+        }
+
+        SetVolumeLight(level, settings.Ambient, settings.AccurateVolumes);
+        SPDLOG_INFO("Delta lights: {} of {}\nIndices: {} of {}", level.LightDeltaIndices.size(), MaxDynamicLights, level.LightDeltas.size(), MaxLightDeltas);
+        return stats;
+    }
+
+    LightingStats LightLevel(Level& level, const LightingTextureTable& textures, const LightSettings& settings, uint threads) {
+        auto start = std::chrono::steady_clock::now();
+
+        auto contexts = CreateLightContexts(level, textures, settings, threads);
+        LightingCounters counters;
+        VisibilityCache sharedHitTests;
+        RunLightContexts(level, contexts, GetLightingPasses(settings), counters, sharedHitTests);
+
+        auto stats = MergeLightContexts(level, contexts, settings);
+        stats.Time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    // Occlusion results from the last lighting run. Kept between runs and saved next to the level.
+    struct LightingCache {
+        VisibilityCache HitTests;
+        List<uint64> SegmentHashes; // Geometry the results were traced against
+        float DistanceThreshold = 0;
+    };
+
+    namespace {
+        constexpr auto LIGHTING_CACHE_ID = MakeFourCC("ILTC");
+        constexpr uint32 LIGHTING_CACHE_VERSION = 1;
+        LightingCache PersistentCache;
+    }
+
+    // Hashes everything about a segment that affects occlusion: vertices, connections, textures and walls
+    uint64 HashSegmentOcclusion(const Level& level, const Segment& seg) {
+        auto hash = HashBytes(span((const ubyte*)seg.Connections.data(), sizeof(SegID) * seg.Connections.size()));
+
+        for (auto& index : seg.Indices) {
+            if (Seq::inRange(level.Vertices, index))
+                hash = HashBytes(span((const ubyte*)&level.Vertices[index], sizeof(Vector3)), hash);
+        }
+
+        for (auto& side : seg.Sides) {
+            auto wall = level.TryGetWall(side.Wall);
+            int32 values[] = {
+                (int32)side.TMap,
+                (int32)side.TMap2,
+                (int32)side.Type,
+                wall ? (int32)wall->Type : -1,
+                wall && wall->BlocksLight ? (int32)*wall->BlocksLight : -1
+            };
+
+            hash = HashBytes(span((const ubyte*)values, sizeof values), hash);
+        }
+
+        return hash;
+    }
+
+    List<uint64> HashSegmentsOcclusion(const Level& level) {
+        return Seq::map(level.Segments, [&level](auto& seg) { return HashSegmentOcclusion(level, seg); });
+    }
+
+    // Takes the cached results that are still valid for the level.
+    // A result depends on every segment its ray was tested against, which are the segments in range of the source.
+    VisibilityCache TakeCachedHitTests(Level& level, const LightingTextureTable& textures, span<const uint64> segmentHashes, const LightSettings& settings) {
+        auto cache = std::move(PersistentCache);
+        PersistentCache = {};
+
+        if (cache.HitTests.Count() == 0 || cache.DistanceThreshold != settings.DistanceThreshold)
+            return {};
+
+        Set<SegID> changed;
+        for (int id = 0; id < segmentHashes.size(); id++) {
+            if (id >= cache.SegmentHashes.size() || segmentHashes[id] != cache.SegmentHashes[id])
+                changed.insert((SegID)id);
+        }
+
+        if (changed.empty()) {
+            Metrics::ReusedHitTests = cache.HitTests.Count();
+            return std::move(cache.HitTests);
+        }
+
+        if (changed.size() == segmentHashes.size())
+            return {}; // Nothing in common
+
+        Dictionary<Tag, bool> validSources;
+        VisibilityCache hitTests(cache.HitTests.Count());
+
+        cache.HitTests.ForEach([&](uint64 id, bool occluded) {
+            auto src = UnpackHitTestSource(id);
+            auto [source, inserted] = validSources.try_emplace(src, false);
+
+            if (inserted && level.SegmentExists(src)) {
+                auto inRange = GetSegmentsInRange(level, textures, src, settings.DistanceThreshold);
+                source->second = ranges::none_of(inRange, [&changed](SegID seg) { return changed.contains(seg); });
+            }
+
+            if (source->second)
+                hitTests.Insert(id, occluded);
+        });
+
+        SPDLOG_INFO("Reusing {} of {} cached hit tests. {} segments changed.", hitTests.Count(), cache.HitTests.Count(), changed.size());
+        Metrics::ReusedHitTests = hitTests.Count();
+        return hitTests;
+    }
+
+    void WriteLightingCache(const filesystem::path& path) {
+        auto& cache = PersistentCache;
+        if (cache.HitTests.Count() == 0) return;
+
         try {
-            ScopedCursor cursor(IDC_WAIT);
-            Metrics::Reset();
-            level.LightDeltaIndices.clear();
-            level.LightDeltas.clear();
+            List<uint64> entries;
+            entries.reserve(cache.HitTests.Count());
+            cache.HitTests.ForEach([&entries](uint64 id, bool occluded) {
+                entries.push_back(id << 1 | (uint64)occluded);
+            });
+
+            std::ofstream file(path, std::ios::binary);
+            StreamWriter writer(file);
+            writer.Write(LIGHTING_CACHE_ID);
+            writer.Write(LIGHTING_CACHE_VERSION);
+            writer.WriteFloat(cache.DistanceThreshold);
+            writer.Write((uint32)cache.SegmentHashes.size());
+            writer.WriteBytes(span((const ubyte*)cache.SegmentHashes.data(), cache.SegmentHashes.size() * sizeof(uint64)));
+            writer.Write((uint64)entries.size());
+            writer.WriteBytes(span((const ubyte*)entries.data(), entries.size() * sizeof(uint64)));
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to write lighting cache `{}`: {}", path.string(), e.what());
+        }
+    }
 
-            ScopedTimer timer(&Metrics::LightCalculationTime);
+    void ReadLightingCache(const filesystem::path& path) {
+        PersistentCache = {};
+        if (!filesystem::exists(path)) return;
+
+        try {
+            auto size = filesystem::file_size(path);
+            List<ubyte> data(size);
+            std::ifstream file(path, std::ios::binary);
+            if (!file.read((char*)data.data(), size))
+                throw Exception("Error reading file");
+
+            constexpr size_t headerSize = sizeof(uint32) * 4;
+            if (size < headerSize) throw Exception("File is too small");
+
+            StreamReader reader(data);
+            if (reader.ReadUInt32() != LIGHTING_CACHE_ID || reader.ReadUInt32() != LIGHTING_CACHE_VERSION)
+                return; // Written by a different version
+
+            LightingCache cache;
+            cache.DistanceThreshold = reader.ReadFloat();
+            auto segments = reader.ReadUInt32();
+            if (headerSize + (segments + 1) * sizeof(uint64) > size)
+                throw Exception("Segment count is out of range");
+
+            cache.SegmentHashes.resize(segments);
+            reader.ReadBytes(cache.SegmentHashes.data(), segments * sizeof(uint64));
+
+            auto count = (uint64)reader.ReadInt64();
+            if (headerSize + (segments + 1 + count) * sizeof(uint64) != size)
+                throw Exception("Entry count doesn't match the file size");
+
+            List<uint64> entries(count);
+            reader.ReadBytes(entries.data(), count * sizeof(uint64));
+
+            cache.HitTests.Reserve(count);
+            for (auto& entry : entries)
+                cache.HitTests.Insert(entry >> 1, entry & 1);
+
+            PersistentCache = std::move(cache);
+            SPDLOG_INFO("Loaded {} cached hit tests from `{}`", count, path.string());
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to read lighting cache `{}`: {}", path.string(), e.what());
+        }
+    }
+
+    void ClearLightingCache() {
+        PersistentCache = {};
+    }
+
+    // Lights a copy of the level on background threads so the editor stays responsive.
+    // The workers wait for each other after the direct pass and each bounce, so a preview can be published.
+    class LightingJob {
+        Level _level; // Copy that the workers read from
+        Level* _target;
+        LightSettings _settings;
+        LightingTextureTable _textures; // Read up front so the workers don't touch the game data
+        List<LightContext> _contexts;
+        LightingCounters _counters;
+        std::thread _thread;
+        std::atomic<bool> _finished = false;
+        std::exception_ptr _error;
+        std::mutex _lock; // Guards the preview
+        int _lights = 0, _passes = 0;
+        std::chrono::steady_clock::time_point _start;
+
+        List<SideLighting> _preview; // Lighting for six sides per segment
+        int _previewPass = 0, _appliedPass = 0;
+        List<SideLighting> _original; // Lighting before the job started, restored when cancelled
+        List<Color> _originalVolumes;
+        VisibilityCache _sharedHitTests; // Cached results and the direct pass results from every thread
+        List<uint64> _segmentHashes;
+        bool _stale = false; // The level was edited after the job started
+
+    public:
+        LightingJob(Level& level, const LightSettings& settings)
+            : _level(level), _target(&level), _settings(settings), _textures(CreateLightingTextureTable()) {
+            _start = std::chrono::steady_clock::now();
 
             auto hardwareThreads = std::thread::hardware_concurrency();
             SPDLOG_INFO("Lighting level. {} available threads.", hardwareThreads);
             auto availThreads = settings.Multithread && hardwareThreads > 1 ? hardwareThreads - 1 : 1; // leave 1 thread unused
 
-            SetAmbientLight(settings.Ambient);
+            _contexts = CreateLightContexts(_level, _textures, settings, availThreads);
+            _passes = GetLightingPasses(settings);
 
-            auto lights = GatherLightSources(level, settings);
-            auto bucketSize = (int)std::max(lights.size() / availThreads, size_t(1));
+            for (auto& ctx : _contexts)
+                _lights += (int)ctx.Lights.size();
 
-            if (settings.CheckCoplanar)
-                ReduceCoplanarBrightness(level, lights);
+            _segmentHashes = HashSegmentsOcclusion(_level);
+            _sharedHitTests = TakeCachedHitTests(_level, _textures, _segmentHashes, settings);
 
-            List<LightContext> threads(availThreads);
-            int bucketIndex = 0;
+            _original.reserve(level.Segments.size() * 6);
+            _originalVolumes.reserve(level.Segments.size());
 
-            // assign lights to threads based on their spatial locality
-            std::function<void(OctreeLeaf&)> addNodeLights = [&](const OctreeLeaf& leaf) {
-                if (bucketIndex >= threads.size()) {
-                    // ran out of buckets, dump everything into 0
-                    Seq::append(threads[0].Lights, leaf.Lights);
-                }
-                else if (leaf.Lights.size() <= bucketSize) {
-                    // lights in this leaf fit into a bucket
-                    Seq::append(threads[bucketIndex].Lights, leaf.Lights);
-                    if (threads[bucketIndex].Lights.size() >= bucketSize)
-                        bucketIndex++;
-                }
-                else {
-                    for (int i = 0; i < 8; i++) {
-                        if (leaf.Children[i]) {
-                            addNodeLights(*leaf.Children[i]);
-                        }
-                    }
-                }
+            for (auto& seg : level.Segments) {
+                for (auto& side : seg.Sides)
+                    _original.push_back(side.Light);
+
+                _originalVolumes.push_back(seg.VolumeLight);
+            }
+
+            _thread = std::thread([this] { Run(); });
+        }
+
+        ~LightingJob() {
+            _counters.Cancelled = true;
+            if (_thread.joinable())
+                _thread.join();
+        }
+
+        LightingJob(const LightingJob&) = delete;
+        LightingJob(LightingJob&&) = delete;
+        LightingJob& operator=(const LightingJob&) = delete;
+        LightingJob& operator=(LightingJob&&) = delete;
+
+        bool IsFinished() const { return _finished; }
+        void Cancel() { _counters.Cancelled = true; }
+
+        LightingProgress GetProgress() const {
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+            return {
+                .Running = true,
+                .Lights = _lights,
+                .LightsDone = _counters.LightsDone,
+                .Passes = _passes,
+                .PassesDone = _counters.PassesDone,
+                .RaysPerSecond = elapsed > 0 ? _counters.RaysCast / elapsed : 0
             };
+        }
 
-            auto tree = CreateLightOctree(level, lights, bucketSize);
-            addNodeLights(tree);
-            Seq::sortBy(threads, [](const LightContext& a, const LightContext& b) {
-                return a.Lights.size() > b.Lights.size();
-            });
+        // Copies the latest preview into the level. Returns true if the level changed.
+        bool ApplyPreview() {
+            std::scoped_lock lock(_lock);
+            if (_previewPass == _appliedPass || !IsTargetValid()) return false;
+            _appliedPass = _previewPass;
+            auto changed = SetLighting(_preview);
+            // Objects are lit by the volume light, so keep it in step with the preview
+            SetVolumeLight(*_target, changed, _settings.Ambient, _settings.AccurateVolumes);
+            return true;
+        }
+
+        // Restores the lighting from before the job started
+        void Restore() {
+            if (!IsTargetValid()) return;
+            SetLighting(_original);
 
-            // Count the number of empty and filled threads
-            int emptyThreads = 0, filledThreads = 0;
-            for (auto& thread : threads) {
-                if (thread.Lights.empty())
-                    emptyThreads++;
-                else
-                    filledThreads++;
+            for (int segId = 0; segId < _target->Segments.size(); segId++) {
+                auto& seg = _target->Segments[segId];
+                if (!seg.LockVolumeLight)
+                    seg.VolumeLight = _originalVolumes[segId];
             }
+        }
+
+        // Stores the occlusion results for the next run. Results are valid even if the job was cancelled.
+        void KeepHitTests() {
+            for (auto& ctx : _contexts)
+                _sharedHitTests.Merge(ctx.HitTests);
+
+            PersistentCache = { std::move(_sharedHitTests), _segmentHashes, _settings.DistanceThreshold }; // Hashes are still needed to validate the results
+        }
+
+        // Waits for the workers to stop
+        void Wait() {
+            if (_thread.joinable())
+                _thread.join();
+        }
+
+        // Merges the results into the level. Waits for the job to finish.
+        void Apply() {
+            Wait();
 
-            // Fill empty threads by splitting large buckets
-            for (int i = 0; i < emptyThreads; i++) {
-                auto& src = threads[i].Lights;
-                auto& dst = threads[filledThreads + i].Lights;
-                // move half of the lights to a new thread
-                auto len = src.size() / 2;
-                std::move(src.begin() + len, src.end(), std::back_inserter(dst));
-                src.resize(src.size() - dst.size());
-                //assert(originalLen == src.size() + dst.size());
+            if (_error) {
+                Restore();
+                std::rethrow_exception(_error);
             }
 
-            // If single threaded, preallocate a single large buffer
-            if (availThreads == 1) {
-                threads[0].HitTests = Dictionary<int64, bool>{ 1'000'000 };
-                threads[0].RayCasts = Dictionary<Tag, LightRayCast>{ 1000 };
+            if (_counters.Cancelled) return;
+
+            KeepHitTests();
+
+            if (!IsTargetValid()) {
+                SetStatusMessageWarn("The level was edited while lighting. Discarding results.");
+                return;
             }
 
-            // Dispatch worker threads
-            std::atomic activeThreads = 0;
-            for (auto& ctx : threads) {
-                if (ctx.Lights.empty()) continue;
+            auto stats = MergeLightContexts(*_target, _contexts, _settings);
+            Metrics::CacheHits += stats.CacheHits;
+            Metrics::RayHits += stats.RayHits;
+            Metrics::RaysCast += stats.RaysCast;
+            Metrics::LightCalculationTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
 
-                ctx.Settings = settings;
-                ctx.Id = activeThreads++;
+            if (stats.DynamicLightLimit)
+                ShowWarningMessage(L"Maximum dynamic lights reached. Some lights will not work as expected.");
 
-                // Accumulate radiosity bounces
-                ctx.Thread = std::thread([&ctx, &level] {
-                    SPDLOG_INFO("Dispatching thread {} with {} lights", ctx.Id, ctx.Lights.size());
-                    ctx.EmitDirectLight(level);
+            if (stats.LightDeltaLimit)
+                ShowWarningMessage(L"Maximum light deltas reached. Some lights will not work as expected.");
 
-                    auto bounces = std::clamp(ctx.Settings.Bounces, 0, 10);
+            Editor::History.SnapshotLevel("Light Level");
+        }
 
-                    for (int i = 0; i < bounces; i++) {
-                        for (auto& light : ctx.RayCasts | views::values) {
-                            auto& info = CastBounces(level, light, ctx);
-                            info.AccumulatePass(!(ctx.Settings.SkipFirstPass && i == 0));
-                        }
-                    }
+    private:
+        // Results are mapped to the level by segment index, so they are stale if the level was edited while lighting.
+        // Undo and redo don't raise a load event, so the segments are compared against the ones the job started with.
+        bool IsTargetValid() {
+            if (!_stale) {
+                _stale = _target->Segments.size() != _level.Segments.size() ||
+                    HashSegmentsOcclusion(*_target) != _segmentHashes;
+            }
+
+            return !_stale;
+        }
 
-                    if (!ctx.Settings.EnableColor)
-                        DesaturateAccumulated(ctx.RayCasts);
+        // Returns the segments with sides that changed
+        List<SegID> SetLighting(const List<SideLighting>& lighting) {
+            List<SegID> changed;
+
+            for (int segId = 0; segId < _target->Segments.size(); segId++) {
+                auto& seg = _target->Segments[segId];
+                bool segChanged = false;
+
+                for (int sideId = 0; sideId < 6; sideId++) {
+                    auto& side = seg.Sides[sideId];
+                    auto& light = lighting[segId * 6 + sideId];
+
+                    for (int vert = 0; vert < 4; vert++) {
+                        if (side.LockLight[vert] || side.Light[vert] == light[vert]) continue;
+                        side.Light[vert] = light[vert];
+                        segChanged = true;
+                    }
+                }
 
-                    SPDLOG_INFO("Thread {} finished. Lights: {} Cache size: {}", ctx.Id, ctx.Lights.size(), ctx.HitTests.size());
-                });
+                if (segChanged)
+                    changed.push_back((SegID)segId);
             }
 
-            for (auto& ctx : threads) {
-                if (ctx.Thread.joinable())
-                    ctx.Thread.join();
+            return changed;
+        }
+
+        void Run() {
+            try {
+                RunLightContexts(_level, _contexts, _passes, _counters, _sharedHitTests, [this] { PublishPreview(); });
+            }
+            catch (...) {
+                _error = std::current_exception();
             }
 
-            auto maxValue = std::clamp(settings.MaxValue, 0.0f, 10.0f);
-            const Color max = { maxValue, maxValue, maxValue, 1 };
+            _finished = true;
+        }
 
-            // Merge the results from each light
-            for (auto& ctx : threads) {
-                // updating the level must be done in serial
-                SetSideLighting(level, ctx.RayCasts, max, settings.EnableColor);
-                if (settings.EnableColor)
-                    ClampColorBrightness(level, settings.MaxValue);
+        // Combines the ambient light with the light accumulated so far
+        void PublishPreview() {
+            auto maxValue = std::clamp(_settings.MaxValue, 0.0f, 10.0f);
+            const Color max = { maxValue, maxValue, maxValue, 1 };
+            const SideLighting ambient = { _settings.Ambient, _settings.Ambient, _settings.Ambient, _settings.Ambient };
+            List<SideLighting> preview(_level.Segments.size() * 6, ambient);
+
+            for (auto& ctx : _contexts) {
+                for (auto& cast : ctx.RayCasts | views::values) {
+                    for (auto& [dest, accumulated] : cast.Accumulated) {
+                        auto& light = preview[(int)dest.Segment * 6 + (int)dest.Side];
+
+                        for (int vert = 0; vert < 4; vert++) {
+                            auto color = accumulated[vert];
+                            if (!_settings.EnableColor) {
+                                color.AdjustSaturation(0);
+                                light[vert] += color;
+                                ClampColor(light[vert], { 0, 0, 0, 1 }, max);
+                            }
+                            else {
+                                light[vert] += color;
+                            }
+                        }
+                    }
+                }
+            }
 
-                SetDynamicLights(level, ctx.RayCasts);
-                Metrics::CacheHits += ctx.CacheHits;
-                Metrics::RayHits += ctx.HitStats;
-                Metrics::RaysCast += ctx.CastStats;
+            if (_settings.EnableColor) {
+                for (auto& light : preview)
+                    for (auto& color : light)
+                        ScaleColor(color, _settings.MaxValue);
             }
 
-            SetVolumeLight(level, settings.AccurateVolumes);
+            std::scoped_lock lock(_lock);
+            _preview = std::move(preview);
+            _previewPass = _counters.PassesDone;
+        }
+    };
+
+    namespace {
+        Ptr<LightingJob> Job;
+    }
 
-            SPDLOG_INFO("Delta lights: {} of {}\nIndices: {} of {}", level.LightDeltaIndices.size(), MaxDynamicLights, level.LightDeltas.size(), MaxLightDeltas);
-            Editor::History.SnapshotLevel("Light Level");
+    LightingProgress GetLightingProgress() {
+        return Job ? Job->GetProgress() : LightingProgress{};
+    }
+
+    void CancelLighting(bool restore) {
+        if (!Job) return;
+        Job->Cancel();
+        Job->Wait();
+
+        if (restore) {
+            Job->Restore();
+            Job->KeepHitTests();
+            Events::LevelChanged(LevelChangeKind::Lighting);
+        }
+
+        Job.reset();
+    }
+
+    void UpdateLighting() {
+        if (!Job) return;
+
+        if (Job->ApplyPreview())
+            Events::LevelChanged(LevelChangeKind::Lighting);
+
+        if (!Job->IsFinished()) return;
+
+        try {
+            Job->Apply();
+        }
+        catch (const std::exception& e) {
+            ShowErrorMessage(e);
+        }
+
+        Job.reset();
+        Events::LevelChanged(LevelChangeKind::Lighting);
+    }
+
+    // Starts lighting the level geometry and volumes in the background. Restarts the job if one is running.
+    void Commands::LightLevel(Level& level, const LightSettings& settings) {
+        try {
+            CancelLighting();
+            Metrics::Reset();
+            Job = MakePtr<LightingJob>(level, settings);
         }
         catch (const std::exception& e) {
             ShowErrorMessage(e);
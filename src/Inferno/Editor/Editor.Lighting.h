@@ -7,18 +7,78 @@ namespace Inferno::Editor {
         inline uint64 RaysCast = 0;
         inline uint64 RayHits = 0;
         inline uint64 CacheHits = 0;
+        inline uint64 ReusedHitTests = 0; // Results loaded from the lighting cache
 
         inline int64 LightCalculationTime = 0;
 
         inline void Reset() {
-            RaysCast = RayHits = CacheHits = 0;
+            RaysCast = RayHits = CacheHits = ReusedHitTests = 0;
             LightCalculationTime = 0;
         }
     };
 
+    // Texture properties used by the light solver
+    struct LightingTexture {
+        float Lighting = 0;
+        Color AverageColor;
+        bool Transparent = false;
+        bool SuperTransparent = false;
+        bool Destroyable = false; // Lights using this texture are dynamic
+    };
+
+    // Texture properties indexed by LevelTexID, so the solver doesn't depend on the loaded game data
+    struct LightingTextureTable {
+        List<LightingTexture> Textures;
+        LightingTexture Default; // Used for invalid IDs
+
+        const LightingTexture& Get(LevelTexID id) const {
+            return Seq::inRange(Textures, (int)id) ? Textures[(int)id] : Default;
+        }
+    };
+
+    // Creates a texture table from the game data of the loaded level
+    LightingTextureTable CreateLightingTextureTable();
+
     Color GetLightColor(const SegmentSide& side, bool enableColor);
+    Color GetLightColor(const SegmentSide& side, const LightingTextureTable& textures, bool enableColor);
+
+    struct LightingStats {
+        int Lights = 0;
+        uint64 RaysCast = 0;
+        uint64 RayHits = 0;
+        uint64 CacheHits = 0;
+        int64 Time = 0; // Microseconds
+        bool DynamicLightLimit = false; // Some dynamic lights were discarded
+        bool LightDeltaLimit = false;
+    };
+
+    // Lights the level using up to the given number of threads and waits for the result.
+    // Doesn't use any editor or game state, so several levels can be lit at once.
+    LightingStats LightLevel(Level& level, const LightingTextureTable& textures, const LightSettings& settings, uint threads);
+
+    struct LightingProgress {
+        bool Running = false;
+        int Lights = 0, LightsDone = 0; // Lights finished in the current pass
+        int Passes = 0, PassesDone = 0; // The direct pass and each bounce
+        double RaysPerSecond = 0;
+    };
+
+    LightingProgress GetLightingProgress();
+
+    // Stops the lighting job. Restores the previous lighting unless the level was replaced.
+    void CancelLighting(bool restore = true);
+
+    // Applies the preview and results of the lighting job. Called once per frame.
+    void UpdateLighting();
+
+    // Saves the occlusion results of the last lighting run, so unchanged geometry doesn't need to be traced again
+    void WriteLightingCache(const filesystem::path& path);
+    // Loads occlusion results saved by WriteLightingCache. Results are checked against the level before use.
+    void ReadLightingCache(const filesystem::path& path);
+    void ClearLightingCache();
 
     namespace Commands {
+        // Starts lighting the level in the background. Restarts the job if one is running.
         void LightLevel(Level&, const LightSettings&);
     }
 }
\ No newline at end of file
@@ -65,7 +65,7 @@ namespace Inferno::Editor {
         obj->Position = position;
 
         // Leave the last good ID if nothing contains the object
-        auto segId = FindContainingSegment(level, position);
+        auto segId = FindContainingSegment(level, position, obj->Segment);
         if (segId != SegID::None) obj->Segment = segId;
         return true;
     }
@@ -327,7 +327,7 @@ namespace Inferno::Editor {
     // Updates the segment of the object based on position
     void UpdateObjectSegment(Level& level, Object& obj) {
         if (!PointInSegment(level, obj.Segment, obj.Position)) {
-            auto id = FindContainingSegment(level, obj.Position);
+            auto id = FindContainingSegment(level, obj.Position, obj.Segment);
             // Leave the last good ID if nothing contains the object
             if (id != SegID::None) obj.Segment = id;
         }
@@ -10,10 +10,16 @@
 #include "Editor.Diagnostics.h"
 #include "Game.Segment.h"
 #include "TunnelBuilder.h"
+#include "TrianglePacket.h"
+#include "SegmentLocator.h"
 
 namespace Inferno::Editor {
+    namespace {
+        SegmentLocator LevelLocator;
+    }
+
     void JoinAllTouchingSides(Level& level, span<SegID> segs) {
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
 
         for (auto& seg : segs) {
             auto faces = FacesForSegment(seg);
@@ -21,26 +27,6 @@ namespace Inferno::Editor {
         }
     }
 
-    void RemoveLightDeltasForSegment(Level& level, SegID seg) {
-        int16 removed = 0;
-        for (auto& index : level.LightDeltaIndices) {
-            index.Index -= removed;
-
-            List<int> toRemove;
-            for (int i = 0; i < index.Count; i++) {
-                if (level.LightDeltas[index.Index + i].Tag.Segment == seg)
-                    toRemove.push_back(index.Index + i);
-            }
-
-            Seq::sortDescending(toRemove);
-            for (auto& i : toRemove)
-                Seq::removeAt(level.LightDeltas, i);
-
-            removed += (int16)toRemove.size();
-            index.Count -= (uint8)toRemove.size();
-        }
-    }
-
     bool AddFlickeringLight(Level& level, Tag tag, FlickeringLight light) {
         if (!CanAddFlickeringLight(level, tag)) return false;
         light.Tag = tag;
@@ -116,49 +102,95 @@ namespace Inferno::Editor {
         return true;
     }
 
-    // Shifts any segment references greater or equal to ref by value.
-    // For use with delete / undo
-    void ShiftSegmentRefs(Level& level, SegID ref, int value) {
-        auto shift = [value, ref](SegID& id) {
-            if (id >= ref) id += (SegID)value;
+    // Rewrites segment references using a table of old to new ids. Deleted segments map to None.
+    // References to deleted segments are removed. For use with delete.
+    void RemapSegmentRefs(Level& level, span<const SegID> remap) {
+        auto map = [remap](SegID id) {
+            return Seq::inRange(remap, (int)id) ? remap[(int)id] : id;
         };
 
         // Update connections
         for (auto& seg : level.Segments) {
             for (auto& c : seg.Connections)
-                shift(c);
+                c = map(c);
         }
 
         // Update object owners
         for (auto& obj : level.Objects)
-            shift(obj.Segment);
+            obj.Segment = map(obj.Segment);
 
         for (auto& matcen : level.Matcens)
-            shift(matcen.Segment);
+            matcen.Segment = map(matcen.Segment);
 
         // Update triggers
-        for (auto& trigger : level.Triggers) {
-            for (auto& target : trigger.Targets)
-                shift(target.Segment);
-        }
+        auto remapTargets = [&map](auto& targets) {
+            for (int i = (int)targets.Count() - 1; i >= 0; i--) {
+                auto& target = targets[i];
+                if (target.Segment == SegID::None) continue;
+                target.Segment = map(target.Segment);
+                if (target.Segment == SegID::None)
+                    targets.Remove(i);
+            }
+        };
+
+        for (auto& trigger : level.Triggers)
+            remapTargets(trigger.Targets);
 
-        for (auto& trigger : level.ReactorTriggers)
-            shift(trigger.Segment);
+        remapTargets(level.ReactorTriggers);
 
         // Update walls
         for (auto& wall : level.Walls)
-            shift(wall.Tag.Segment);
+            wall.Tag.Segment = map(wall.Tag.Segment);
 
-        if (TunnelBuilderArgs.Start.Tag.Segment == ref)
-            TunnelBuilderArgs.Start = {};
-        else
-            shift(TunnelBuilderArgs.Start.Tag.Segment);
+        for (auto& light : level.FlickeringLights)
+            light.Tag.Segment = map(light.Tag.Segment);
 
-        if (TunnelBuilderArgs.End.Tag.Segment == ref)
-            TunnelBuilderArgs.End = {};
-        else
-            shift(TunnelBuilderArgs.End.Tag.Segment);
+        std::erase_if(level.FlickeringLights, [](auto& light) { return light.Tag.Segment == SegID::None; });
+
+        // Rebuild the light deltas without the deleted lights and sides
+        {
+            List<LightDeltaIndex> indices;
+            List<LightDelta> deltas;
+            indices.reserve(level.LightDeltaIndices.size());
+            deltas.reserve(level.LightDeltas.size());
+
+            for (auto index : level.LightDeltaIndices) {
+                index.Tag.Segment = map(index.Tag.Segment);
+                if (index.Tag.Segment == SegID::None) continue; // light was deleted
+
+                auto start = deltas.size();
+                for (int i = 0; i < index.Count; i++) {
+                    if (!Seq::inRange(level.LightDeltas, index.Index + i)) break;
+                    auto delta = level.LightDeltas[index.Index + i];
+                    delta.Tag.Segment = map(delta.Tag.Segment);
+                    if (delta.Tag.Segment != SegID::None)
+                        deltas.push_back(delta);
+                }
+
+                if (index.Count > 0) {
+                    index.Index = (int16)start;
+                    index.Count = uint8(deltas.size() - start);
+                }
+
+                indices.push_back(index);
+            }
 
+            level.LightDeltaIndices = std::move(indices);
+            level.LightDeltas = std::move(deltas);
+        }
+
+        level.SecretExitReturn = map(level.SecretExitReturn);
+        if (level.SecretExitReturn == SegID::None)
+            level.SecretExitReturn = SegID(0);
+
+        auto remapTunnelHandle = [&map](TunnelHandle& handle) {
+            if (handle.Tag.Segment == SegID::None) return;
+            handle.Tag.Segment = map(handle.Tag.Segment);
+            if (handle.Tag.Segment == SegID::None) handle = {};
+        };
+
+        remapTunnelHandle(TunnelBuilderArgs.Start);
+        remapTunnelHandle(TunnelBuilderArgs.End);
         UpdateTunnelPreview();
     }
 
@@ -282,94 +314,103 @@ namespace Inferno::Editor {
         return Seq::ofSet(nearby);
     }
 
-    void DeleteSegment(Level& level, SegID segId) {
-        if (level.Segments.size() <= 1) return; // don't delete the last segment
-        if (!level.SegmentExists(segId)) return;
+    // Deletes segments and everything attached to them, then renumbers the remaining segments in a single pass
+    void RemoveSegments(Level& level, span<const SegID> ids) {
+        if (level.Segments.empty()) return;
 
-        RemoveMatcen(level, level.GetSegment(segId).Matcen);
+        List<bool> deleted(level.Segments.size());
+        size_t count = 0;
 
-        // Remove contained objects
-        {
-            List<ObjID> objects;
-            for (int i = 0; i < level.Objects.size(); i++) {
-                if (level.Objects[i].Segment == segId)
-                    objects.push_back((ObjID)i);
-            }
+        for (auto& id : ids) {
+            if (!level.SegmentExists(id) || deleted[(int)id]) continue;
+            deleted[(int)id] = true;
+            count++;
+        }
 
-            // reverse sort should keep the object iterator valid
-            Seq::sortDescending(objects);
-            for (auto& obj : objects)
-                DeleteObject(level, obj);
+        if (count >= level.Segments.size()) {
+            // don't delete the last segment
+            deleted[0] = false;
+            count--;
         }
 
+        if (count == 0) return;
+
+        auto isDeleted = [&deleted](SegID id) {
+            return Seq::inRange(deleted, (int)id) && deleted[(int)id];
+        };
+
+        for (int id = 0; id < level.Segments.size(); id++) {
+            if (deleted[id])
+                RemoveMatcen(level, level.Segments[id].Matcen);
+        }
+
+        // Remove contained objects
+        if (std::erase_if(level.Objects, [&isDeleted](auto& obj) { return isDeleted(obj.Segment); }) > 0)
+            Events::ObjectsChanged();
+
         // Remove walls and connected walls
         {
             List<WallID> walls;
 
-            // Remove walls on this seg
             for (int16 wallId = 0; wallId < level.Walls.size(); wallId++) {
-                if (level.Walls[wallId].Tag.Segment == segId)
+                if (isDeleted(level.Walls[wallId].Tag.Segment))
                     walls.push_back((WallID)wallId);
             }
 
-            // Also remove any connected walls
-            for (auto& sideId : SideIDs) {
-                auto conn = level.GetConnectedSide({ segId, sideId });
-                auto cwall = level.TryGetWallID(conn);
-                if (cwall != WallID::None)
-                    walls.push_back(cwall);
+            for (int id = 0; id < level.Segments.size(); id++) {
+                if (!deleted[id]) continue;
+
+                for (auto& sideId : SideIDs) {
+                    auto conn = level.GetConnectedSide({ (SegID)id, sideId });
+                    if (isDeleted(conn.Segment)) continue; // already included
+
+                    auto cwall = level.TryGetWallID(conn);
+                    if (cwall != WallID::None)
+                        walls.push_back(cwall);
+                }
             }
 
-            // reverse sort should keep the object iterator valid
+            // reverse sort should keep the wall ids valid
             Seq::sortDescending(walls);
+            walls.erase(std::unique(walls.begin(), walls.end()), walls.end());
             for (auto& wall : walls)
                 RemoveWall(level, wall);
         }
 
         // Remove all connections
-        for (auto& id : SideIDs)
-            DetachSide(level, { segId, id });
-
-        // Remove trigger targets pointing at this segment
-        for (auto& trigger : level.Triggers) {
-            for (int i = (int)trigger.Targets.Count() - 1; i >= 0; i--) {
-                if (trigger.Targets[i].Segment == segId)
-                    trigger.Targets.Remove(i);
-            }
-        }
-
-        RemoveLightDeltasForSegment(level, segId);
-
-        // Remove flickering lights
-        for (int i = (int)level.FlickeringLights.size() - 1; i >= 0; i--) {
-            if (level.FlickeringLights[i].Tag.Segment == segId)
-                RemoveFlickeringLight(level, level.FlickeringLights[i].Tag);
+        for (int id = 0; id < level.Segments.size(); id++) {
+            if (!deleted[id]) continue;
+            for (auto& sideId : SideIDs)
+                BreakConnection(level, { (SegID)id, sideId });
         }
 
-        // Shift remaining light tags
-        for (auto& light : level.FlickeringLights) {
-            if (light.Tag.Segment > segId)
-                light.Tag.Segment--;
+        List<SegID> remap(level.Segments.size(), SegID::None);
+        int16 next = 0;
+        for (int id = 0; id < level.Segments.size(); id++) {
+            if (!deleted[id])
+                remap[id] = SegID(next++);
         }
 
-        for (auto& light : level.LightDeltas) {
-            if (light.Tag.Segment > segId)
-                light.Tag.Segment--;
-        }
+        Editor::Marked.RemapSegments(remap);
+        RemapSegmentRefs(level, remap);
 
-        for (auto& light : level.LightDeltaIndices) {
-            if (light.Tag.Segment > segId)
-                light.Tag.Segment--;
+        // Compact the remaining segments
+        size_t dest = 0;
+        for (size_t i = 0; i < level.Segments.size(); i++) {
+            if (deleted[i]) continue;
+            if (dest != i) level.Segments[dest] = std::move(level.Segments[i]);
+            dest++;
         }
 
-        Editor::Marked.RemoveSegment(segId);
-
-        // Delete the segment
-        ShiftSegmentRefs(level, segId, -1);
-        Seq::removeAt(level.Segments, (int)segId);
+        level.Segments.erase(level.Segments.begin() + dest, level.Segments.end());
         Events::SegmentsChanged();
     }
 
+    void DeleteSegment(Level& level, SegID segId) {
+        std::array ids = { segId };
+        RemoveSegments(level, ids);
+    }
+
     // Inserts a uniform 20x20 segment centered on the selected face when extrude is false.
     // Uses face normal of length 20 if no offset is provided.
     SegID InsertSegment(Level& level, Tag src, int alignedToVert, InsertMode mode, const Vector3* offset) {
@@ -515,6 +556,8 @@ namespace Inferno::Editor {
             return true;
 
         Ray ray(srcFace.Center(), vec);
+        auto sideHits = IntersectSides(level, level.GetSegment(tag.Segment), ray, true);
+
         for (auto side : SideIDs) {
             if (side == tag.Side || side == opposite)
                 continue;
@@ -524,8 +567,8 @@ namespace Inferno::Editor {
             if (flatness <= 0.90f)
                 return true;
 
-            float dist{};
-            if (tface.Intersects(ray, dist, true) && dist > 0.01f && dist < maxDist) {
+            auto& dist = sideHits[(int)side];
+            if (dist && *dist > 0.01f && *dist < maxDist) {
                 return true;
             }
         }
@@ -591,7 +634,7 @@ namespace Inferno::Editor {
         level.TryAddConnection(srcTag, destId);
         auto nearby = GetNearbySegments(Game::Level, srcTag.Segment);
         WeldVerticesOfOpenSides(Game::Level, nearby, Settings::Editor.CleanupTolerance);
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
         return true;
     }
 
@@ -631,7 +674,7 @@ namespace Inferno::Editor {
             replacements.push_back({ mark, destIndex });
 
         ReplaceVertices(level, replacements);
-        level.UpdateAllGeometricProps();
+        UpdateGeometricProps(level);
         Events::LevelChanged();
         return true;
     }
@@ -668,20 +711,14 @@ namespace Inferno::Editor {
         return id;
     }
 
-    // Estimation that treats the sides as planes instead of triangles
     bool PointInSegment(Level& level, SegID id, const Vector3& point) {
-        if (!level.SegmentExists(id)) return false;
-
-        for (auto& side : SideIDs) {
-            auto face = Face::FromSide(level, id, side);
-            if (face.Distance(point) < 0)
-                return false;
-        }
-
-        return true;
+        return SegmentLocator::Contains(level, id, point);
     }
 
-    SegID FindContainingSegment(Level& level, const Vector3& point) {
+    SegID FindContainingSegment(Level& level, const Vector3& point, SegID hint) {
+        if (&level == &Game::Level)
+            return LevelLocator.Find(level, point, hint);
+
         for (int id = 0; id < level.Segments.size(); id++) {
             auto& seg = level.GetSegment((SegID)id);
             if (Vector3::Distance(seg.Center, point) > 200) continue;
@@ -693,6 +730,10 @@ namespace Inferno::Editor {
         return SegID::None;
     }
 
+    void InvalidateSegmentBounds() {
+        LevelLocator.Invalidate();
+    }
+
     void Commands::AddEnergyCenter() {
         auto& level = Game::Level;
         auto tag = Editor::Selection.Tag();
@@ -886,15 +927,8 @@ namespace Inferno::Editor {
     }
 
     void DeleteSegments(Level& level, span<SegID> ids) {
-        // Must be deleted in descending order to prevent later ids becoming invalid
-        Seq::sortDescending(ids);
-
-        for (auto& segId : ids) {
-            DeleteSegment(level, segId);
-            Editor::Marked.RemoveSegment(segId);
-        }
-
-        PruneVertices(Game::Level);
+        RemoveSegments(level, ids);
+        PruneVertices(level);
     }
 
     // Returns any faces that are not connected to any other segments in the input
@@ -12,7 +12,10 @@ namespace Inferno::Editor {
     bool PointInSegment(Level& level, SegID id, const Vector3& point);
     SegID InsertSegment(Level&, Tag, int alignedToVert, InsertMode mode, const Vector3* offset = nullptr);
 
-    SegID FindContainingSegment(Level& level, const Vector3& point);
+    // Returns the segment containing a point. Searching starts from the hint segment when provided.
+    SegID FindContainingSegment(Level& level, const Vector3& point, SegID hint = SegID::None);
+    // Marks the segment bounds used by FindContainingSegment as out of date
+    void InvalidateSegmentBounds();
     bool CanAddFlickeringLight(Level&, Tag);
 
     bool IsSecretExit(const Trigger& trigger);
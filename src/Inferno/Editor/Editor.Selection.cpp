@@ -2,6 +2,7 @@
 #include "Editor.h"
 #include "Graphics/Render.h"
 #include "Editor.Segment.h"
+#include "TrianglePacket.h"
 
 namespace Inferno::Editor {
     // Returns true if textures match according to selection settings
@@ -22,7 +23,12 @@ namespace Inferno::Editor {
         List<SelectionHit> hits;
         int segid = 0;
         for (auto& seg : level.Segments) {
+            auto sideHits = IntersectSides(level, seg, ray);
+
             for (auto& side : SideIDs) {
+                auto& dist = sideHits[(int)side];
+                if (!dist || *dist < Render::Camera.NearClip) continue;
+
                 if (!includeInvisible) {
                     bool visibleWall = false;
                     if (auto wall = level.TryGetWall(seg.Sides[(int)side].Wall))
@@ -32,18 +38,15 @@ namespace Inferno::Editor {
                 }
 
                 auto face = Face::FromSide(level, seg, side);
-                float dist;
-                if (face.Intersects(ray, dist) && dist >= Render::Camera.NearClip) {
-                    auto intersect = ray.position + dist * ray.direction;
-                    int16 edge = 0;
-                    if (mode == SelectionMode::Point)
-                        // find the point on this face closest to the intersect
-                        edge = face.GetClosestPoint(intersect);
-                    else
-                        edge = face.GetClosestEdge(intersect);
-
-                    hits.push_back({ { SegID(segid), side }, edge, face.Side.AverageNormal, dist });
-                }
+                auto intersect = ray.position + *dist * ray.direction;
+                int16 edge = 0;
+                if (mode == SelectionMode::Point)
+                    // find the point on this face closest to the intersect
+                    edge = face.GetClosestPoint(intersect);
+                else
+                    edge = face.GetClosestEdge(intersect);
+
+                hits.push_back({ { SegID(segid), side }, edge, face.Side.AverageNormal, *dist });
             }
 
             segid++;
@@ -360,19 +363,19 @@ namespace Inferno::Editor {
     }
 
     void EditorSelection::SelectByTexture(LevelTexID id) {
-        int segId = 0;
-        for (auto& seg : Game::Level.Segments) {
-            for (auto& side : SideIDs) {
-                if (seg.SideHasConnection(side) && !seg.SideIsWall(side)) continue;
+        SyncLevelTextures(Game::Level);
+        auto tags = Game::LevelTextures.GetBaseSides(id);
 
-                auto& segSide = seg.GetSide(side);
-                if (segSide.TMap == id || (segSide.TMap2 == id && segSide.HasOverlay())) {
-                    Segment = SegID(segId);
-                    Side = side;
-                    SPDLOG_INFO("Texture {} used in segment {}:{}", (int)id, segId, side);
-                }
-            }
-            segId++;
+        for (auto& tag : Game::LevelTextures.GetOverlaySides(id)) {
+            auto seg = Game::Level.TryGetSegment(tag);
+            if (seg && (!seg->SideHasConnection(tag.Side) || seg->SideIsWall(tag.Side)))
+                tags.insert(tag);
+        }
+
+        for (auto& tag : tags) {
+            Segment = tag.Segment;
+            Side = tag.Side;
+            SPDLOG_INFO("Texture {} used in segment {}:{}", (int)id, tag.Segment, tag.Side);
         }
     }
 
@@ -852,19 +855,38 @@ namespace Inferno::Editor {
         if (!Input::ShiftDown)
             Editor::Marked.Faces.clear();
 
-        for (int id = 0; id < level.Segments.size(); id++) {
-            for (auto& sid : SideIDs) {
-                // Ignore connected sides unless there is a wall; otherwise the texture isn't really used
-                if (level.Segments[id].SideHasConnection(sid) && !level.Segments[id].SideIsWall(sid))
-                    continue;
+        auto isMatch = [&](Tag tag) {
+            // Ignore connected sides unless there is a wall; otherwise the texture isn't really used
+            auto& seg = level.Segments[(int)tag.Segment];
+            if (seg.SideHasConnection(tag.Side) && !seg.SideIsWall(tag.Side))
+                return false;
+
+            auto& side = seg.GetSide(tag.Side);
+            bool match = true;
+
+            if (usePrimary) match &= side.TMap == srcSide->TMap;
+            if (useSecondary) match &= side.TMap2 == srcSide->TMap2;
+            return match;
+        };
 
-                auto& side = level.Segments[id].GetSide(sid);
-                bool match = true;
+        // Only check the sides that use the texture when possible
+        if (usePrimary || (useSecondary && srcSide->HasOverlay())) {
+            SyncLevelTextures(level);
+            auto candidates = usePrimary
+                ? Game::LevelTextures.GetBaseSides(srcSide->TMap)
+                : Game::LevelTextures.GetOverlaySides(srcSide->TMap2);
 
-                if (usePrimary) match &= side.TMap == srcSide->TMap;
-                if (useSecondary) match &= side.TMap2 == srcSide->TMap2;
+            for (auto& tag : candidates) {
+                if (isMatch(tag))
+                    Editor::Marked.Faces.insert(tag);
+            }
+
+            return;
+        }
 
-                if (match)
+        for (int id = 0; id < level.Segments.size(); id++) {
+            for (auto& sid : SideIDs) {
+                if (isMatch({ (SegID)id, sid }))
                     Editor::Marked.Faces.insert({ (SegID)id, sid });
             }
         }
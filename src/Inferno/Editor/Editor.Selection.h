@@ -229,17 +229,16 @@ namespace Inferno::Editor {
             return center;
         }
 
-        // Adjusts remaining selection after removing a segment
-        void RemoveSegment(SegID id) {
+        // Adjusts remaining selection after renumbering segments. Faces on segments mapped to None are removed.
+        void RemapSegments(span<const SegID> remap) {
             auto faces = Seq::ofSet(Faces);
             Faces.clear();
 
             for (auto& face : faces) {
-                if (face.Segment == id) continue; // don't add faces from the deleted segment
-
-                auto seg = face.Segment;
-                if (seg >= id) seg--; // shift ids that are after the removed segment
-                Faces.insert({ seg, face.Side });
+                if (!Seq::inRange(remap, (int)face.Segment)) continue;
+                auto seg = remap[(int)face.Segment];
+                if (seg != SegID::None)
+                    Faces.insert({ seg, face.Side }); // don't add faces from deleted segments
             }
 
             Points.clear(); // this is too hard to deal with
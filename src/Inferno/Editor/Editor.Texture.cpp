@@ -6,6 +6,7 @@
 #include "Editor.Segment.h"
 #include "Editor.Wall.h"
 #include "Editor.IO.h"
+#include "Game.h"
 
 namespace Inferno::Editor {
     void RotateUV(Vector2& uv, const Vector2& pivot, float angle) {
@@ -293,7 +294,7 @@ namespace Inferno::Editor {
                 SetTextureFromWallClip(Game::Level, tag, wclip);
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::Textures | LevelChangeKind::Walls);
         Editor::History.SnapshotSelection();
         Editor::History.SnapshotLevel("Set texture");
     }
@@ -413,6 +414,24 @@ namespace Inferno::Editor {
         }
     }
 
+    void InvalidateLevelTextures(const LevelChangeSet& changes) {
+        if (!changes.Has(LevelChangeKind::Textures | LevelChangeKind::Walls | LevelChangeKind::Geometry))
+            return;
+
+        if (changes.WholeLevel) {
+            Game::LevelTextures.InvalidateAll();
+            return;
+        }
+
+        Game::LevelTextures.Invalidate(changes.Segments);
+        Game::LevelTextures.Invalidate(changes.Sides);
+    }
+
+    void SyncLevelTextures(const Level& level) {
+        InvalidateLevelTextures(Events::PendingLevelChanges);
+        Game::LevelTextures.Sync(level);
+    }
+
     void OnTransformTextures(Level& level, const TransformGizmo& gizmo) {
         if (gizmo.Delta == 0) return;
 
@@ -427,38 +446,41 @@ namespace Inferno::Editor {
             {
                 auto faces = GetSelectedFaces();
                 TransformFaceUVs(level, selection, faces, gizmo, uvTangent, uvBitangent);
+                Events::LevelChanged(LevelChangeKind::UVs, faces);
                 break;
             }
 
             case SelectionMode::Edge:
             {
                 TransformEdgeUVs(level, selection, gizmo, uvTangent, uvBitangent);
+                Events::LevelChanged(LevelChangeKind::UVs, std::array{ Tag(selection) });
                 break;
             }
 
             case SelectionMode::Point:
             {
                 TransformPointUV(level, selection, gizmo, uvTangent, uvBitangent);
+                Events::LevelChanged(LevelChangeKind::UVs, std::array{ Tag(selection) });
                 break;
             }
         }
-
-        Events::LevelChanged();
     }
 
     string OnResetUVs() {
-        for (auto& face : GetSelectedFaces())
+        auto faces = GetSelectedFaces();
+        for (auto& face : faces)
             Editor::ResetUVs(Game::Level, face, Editor::Selection.Point, Settings::Editor.ResetUVsAngle * 90 * DegToRad);
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         return "Reset UVs";
     }
 
     string OnFitUVs() {
-        for (auto& face : GetSelectedFaces())
+        auto faces = GetSelectedFaces();
+        for (auto& face : faces)
             Editor::FitUVs(Game::Level, face, Editor::Selection.Point);
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         return "Fit UVs";
     }
 
@@ -476,7 +498,8 @@ namespace Inferno::Editor {
     }
 
     void Commands::FlipTextureV() {
-        for (auto& tag : GetSelectedFaces()) {
+        auto faces = GetSelectedFaces();
+        for (auto& tag : faces) {
             if (!Game::Level.SegmentExists(tag)) continue;
             // get vector from uvs of selected edge
             auto& side = Game::Level.GetSide(tag);
@@ -485,12 +508,13 @@ namespace Inferno::Editor {
             MirrorUVs(side, uv0, uv1);
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         Editor::History.SnapshotLevel("Flip UVs");
     }
 
     void Commands::FlipTextureU() {
-        for (auto& tag : GetSelectedFaces()) {
+        auto faces = GetSelectedFaces();
+        for (auto& tag : faces) {
             if (!Game::Level.SegmentExists(tag)) continue;
             // get vector from uvs of selected edge
             auto& side = Game::Level.GetSide(tag);
@@ -499,7 +523,7 @@ namespace Inferno::Editor {
             MirrorUVs(side, uv0, uv1);
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         Editor::History.SnapshotLevel("Flip UVs");
     }
 
@@ -510,7 +534,7 @@ namespace Inferno::Editor {
                 side->OverlayRotation = (OverlayRotation)ModSafe((uint16)side->OverlayRotation + rotation, 4);
             }
         }
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::Textures);
         Editor::History.SnapshotLevel("Rotate Overlay");
     }
 
@@ -555,7 +579,7 @@ namespace Inferno::Editor {
 
         destSide.TMap = side.TMap;
         destSide.TMap2 = side.TMap2;
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::Textures | LevelChangeKind::UVs, std::array{ destTag });
         return true;
     }
 
@@ -568,7 +592,7 @@ namespace Inferno::Editor {
             level.GetSide(face).UVs = srcSide.UVs;
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
     }
 
     string OnCopyUVs() {
@@ -589,7 +613,7 @@ namespace Inferno::Editor {
         // selected face to touch or overlap the marked faces
         auto marked = Seq::ofSet(Editor::Marked.Faces);
         Editor::AlignMarked(Game::Level, Editor::Selection.Tag(), marked, Settings::Editor.ResetUVsOnAlign);
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, marked);
         return "Align Marked";
     }
 
@@ -650,7 +674,7 @@ namespace Inferno::Editor {
             RemapUVs(face.Side);
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         return true;
     }
 
@@ -684,7 +708,7 @@ namespace Inferno::Editor {
             RemapUVs(face.Side);
         }
 
-        Events::LevelChanged();
+        Events::LevelChanged(LevelChangeKind::UVs, faces);
         return true;
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "Command.h"
 #include "Gizmo.h"
+#include "Events.h"
 
 namespace Inferno::Editor {
     // Resets UVs of a face, aligning it to the specified edge. Angle applies an additional rotation.
@@ -16,6 +17,12 @@ namespace Inferno::Editor {
 
     void OnTransformTextures(Level&, const TransformGizmo&);
 
+    // Marks the sides touched by texture, wall or geometry changes in the level texture index
+    void InvalidateLevelTextures(const LevelChangeSet& changes);
+
+    // Updates the level texture index, including changes made this frame that haven't been published yet
+    void SyncLevelTextures(const Level&);
+
     namespace Commands {
         void FlipTextureU();
         void FlipTextureV();
@@ -276,6 +276,8 @@ namespace Inferno::Editor {
     bool ImGuiHadMouseFocus = false;
 
     void Update() {
+        UpdateLighting();
+
         // don't do anything when a modal is open
         if (ImGui::GetTopMostPopupModal()) return;
 
@@ -321,11 +323,15 @@ namespace Inferno::Editor {
             case CursorDragMode::Extrude:
                 TransformSelection(level, Editor::Gizmo);
                 UpdateExtrudes(level, Editor::Gizmo);
-                Events::LevelChanged();
+                Events::LevelChanged(LevelChangeKind::Geometry);
                 break;
             case CursorDragMode::Transform:
                 TransformSelection(level, Editor::Gizmo);
-                Events::LevelChanged();
+                if (Settings::Editor.EnableTextureMode)
+                    break; // texture transforms record the sides they change
+
+                Events::LevelChanged(Settings::Editor.SelectionMode == SelectionMode::Object ?
+                                     LevelChangeKind::Objects : LevelChangeKind::Geometry);
                 break;
         }
 
@@ -580,9 +586,18 @@ namespace Inferno::Editor {
     void Initialize() {
         Events::SelectTexture += OnSelectTexture;
         Events::LevelLoaded += [] { Editor::Gizmo.UpdatePosition(); };
+        Events::LevelLoaded += ResetGeometricProps;
+        Events::LevelLoaded += [] {
+            CancelLighting(false);
+            ClearLightingCache();
+        };
         Events::SelectObject += [] { Editor::Gizmo.UpdatePosition(); };
         Events::SelectSegment += [] { Editor::Gizmo.UpdatePosition(); };
-        Events::LevelChanged += [] { Editor::Gizmo.UpdatePosition(); };
+        Events::LevelModified += [](const LevelChangeSet& changes) {
+            if (changes.Has(LevelChangeKind::Geometry | LevelChangeKind::Objects))
+                Editor::Gizmo.UpdatePosition();
+        };
+        Events::LevelModified += InvalidateLevelTextures;
 
         if (Settings::Editor.ReopenLastLevel &&
             !Settings::Editor.RecentFiles.empty() &&
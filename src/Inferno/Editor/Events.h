@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Types.h"
+#include "Utility.h"
 
 namespace Inferno::Editor {
     template <class...TArgs>
@@ -31,11 +32,72 @@ namespace Inferno::Editor {
         Briefings
     };
 
+    // Kinds of changes made to a level
+    enum class LevelChangeKind : uint8 {
+        None = 0,
+        Geometry = 1 << 0, // Vertices, segments or connections
+        Textures = 1 << 1, // Side textures or overlay rotation
+        UVs = 1 << 2, // Texture coordinates of sides
+        Lighting = 1 << 3, // Side lighting
+        Walls = 1 << 4,
+        Objects = 1 << 5,
+        All = 0x3F
+    };
+
+    // Changes made to the level during a frame
+    struct LevelChangeSet {
+        LevelChangeKind Kinds = LevelChangeKind::None;
+        Set<SegID> Segments; // Segments where every side changed
+        Set<Tag> Sides;
+        Set<ObjID> Objects;
+        bool WholeLevel = false; // A change was made without a region. Assume anything of the kinds changed.
+
+        bool Has(LevelChangeKind kinds) const { return (Kinds & kinds) != LevelChangeKind::None; }
+        bool IsEmpty() const { return Kinds == LevelChangeKind::None; }
+
+        // True if only the given kinds changed
+        bool HasOnly(LevelChangeKind kinds) const { return (Kinds & kinds) == Kinds; }
+    };
+
     namespace Events {
         inline Event SelectSegment, SelectObject, LevelLoaded;
         inline Event<LevelTexID, LevelTexID> SelectTexture;
         inline Event<LevelTexID> TextureInfo;
-        inline Event LevelChanged; // Level mesh needs regenerating
+
+        // Published once per frame with all changes made to the level during the frame
+        inline Event<const LevelChangeSet&> LevelModified;
+
+        // Changes made since the last publish
+        inline LevelChangeSet PendingLevelChanges;
+
+        // Records a change that could affect any part of the level
+        inline void LevelChanged(LevelChangeKind kinds = LevelChangeKind::All) {
+            PendingLevelChanges.Kinds |= kinds;
+            PendingLevelChanges.WholeLevel = true;
+        }
+
+        // Records a change to a region of the level. Items can be segment ids, tags or object ids.
+        template<class TItems>
+        void LevelChanged(LevelChangeKind kinds, const TItems& items) {
+            PendingLevelChanges.Kinds |= kinds;
+
+            for (auto& item : items) {
+                using T = std::decay_t<decltype(item)>;
+                if constexpr (std::is_same_v<T, Tag>) PendingLevelChanges.Sides.insert(item);
+                else if constexpr (std::is_same_v<T, SegID>) PendingLevelChanges.Segments.insert(item);
+                else if constexpr (std::is_same_v<T, ObjID>) PendingLevelChanges.Objects.insert(item);
+                else static_assert(!sizeof(T), "Unsupported level change item");
+            }
+        }
+
+        // Publishes the changes recorded during the frame. Called once per frame.
+        inline void PublishLevelChanges() {
+            if (PendingLevelChanges.IsEmpty()) return;
+            auto changes = std::move(PendingLevelChanges);
+            PendingLevelChanges = {};
+            LevelModified(changes);
+        }
+
         inline Event TexturesChanged; // Textures maybe need to be reloaded
         inline Event SegmentsChanged; // Number of segments changed
         inline Event ObjectsChanged; // Number of objects changed
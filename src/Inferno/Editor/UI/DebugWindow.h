@@ -3,9 +3,11 @@
 #include "WindowBase.h"
 #include "Graphics/Render.h"
 #include "Graphics/Render.Debug.h"
+#include "Graphics/TexturePipeline.h"
 #include "Input.h"
 #include "../Editor.h"
 #include "Physics.h"
+#include "SoundSystem.h"
 
 namespace Inferno::Editor {
     class DebugWindow : public WindowBase {
@@ -40,6 +42,20 @@ namespace Inferno::Editor {
             ImGui::Text("QueueLevel: %.2f", Render::Metrics::QueueLevel / 1000.0f);
             ImGui::Text("ImGui: %.2f", Render::Metrics::ImGui / 1000.0f);
 
+            ImGui::Text("Voices: %u Culled: %u Stolen: %u Reused: %u",
+                        Sound::Metrics::ActiveVoices.load(), Sound::Metrics::CulledVoices.load(),
+                        Sound::Metrics::StolenVoices.load(), Sound::Metrics::ReusedInstances.load());
+
+            ImGui::Text("Texture queue: %lld Gather: %.2f Stage: %.2f Upload: %.2f",
+                        Render::Metrics::TextureQueueDepth.load(), Render::Metrics::TextureGather / 1000.0f,
+                        Render::Metrics::TextureStage / 1000.0f, Render::Metrics::TextureUpload / 1000.0f);
+
+            ImGui::Text("Texture memory: %.1f MB Evictions: %lld Reload misses: %lld",
+                        Render::Metrics::TextureResidentBytes / (1024.0f * 1024.0f),
+                        Render::Metrics::TextureEvictions.load(), Render::Metrics::TextureReloadMisses.load());
+
+            ImGui::Text("Geometry updated: %lld segments Total: %lld", Metrics::GeometryUpdates, Metrics::TotalGeometryUpdates);
+
             ImGuiIO& io = ImGui::GetIO();
             //ImGui::Text("Capture - Mouse: %d Keyboard: %d", io.WantCaptureMouse, io.WantCaptureKeyboard);
             ImGui::Text("Mouse (Screen Space): %.0f, %.0f", io.MousePos.x, io.MousePos.y);
@@ -27,7 +27,7 @@ namespace Inferno::Editor {
                 seg.GetSide(Editor::Selection.Side).TMap2 = destroyedTex;
 
                 Inferno::SubtractLight(Game::Level, Editor::Selection.Tag(), seg);
-                Events::LevelChanged();
+                Events::LevelChanged(LevelChangeKind::Textures | LevelChangeKind::Lighting);
                 Render::LoadTextureDynamic(destroyedTex);
                 Editor::History.SnapshotLevel("Break light");
             }
@@ -43,7 +43,7 @@ namespace Inferno::Editor {
 
             if (ImGui::Button("Toggle light")) {
                 Inferno::ToggleLight(Game::Level, Editor::Selection.Tag());
-                Events::LevelChanged();
+                Events::LevelChanged(LevelChangeKind::Lighting);
             }
 
             ImGui::HelpMarker("Previews the effect of toggling dynamic light from flickering or breakable lights");
@@ -103,16 +103,27 @@ namespace Inferno::Editor {
             }
 
 
-            if (ImGui::Button("Light Level")) {
+            if (auto progress = GetLightingProgress(); progress.Running) {
+                if (ImGui::Button("Cancel"))
+                    CancelLighting();
+
+                ImGui::SameLine();
+                auto pass = std::min(progress.PassesDone + 1, progress.Passes);
+                auto fraction = progress.Lights > 0 ? (float)progress.LightsDone / progress.Lights : 1.0f;
+                auto overlay = fmt::format("Pass {} of {}: {} of {} lights", pass, progress.Passes, progress.LightsDone, progress.Lights);
+                ImGui::ProgressBar((progress.PassesDone + fraction) / progress.Passes, { -1, 0 }, overlay.c_str());
+                ImGui::Text("Rays per second: %.0f", progress.RaysPerSecond);
+            }
+            else if (ImGui::Button("Light Level")) {
                 settings.MaxValue = 1.0f; // Clamp lighting to 1 as to not confuse the user
                 Commands::LightLevel(Game::Level, settings);
-                Events::LevelChanged();
             }
 
             ImGui::Text("Time: %.3f s", (float)Metrics::LightCalculationTime / 1000000.0f);
             ImGui::Text("Ray Casts: %s", std::to_string(Metrics::RaysCast).c_str());
             ImGui::Text("Ray Hits: %s", std::to_string(Metrics::RayHits).c_str());
             ImGui::Text("Cache hits: %s", std::to_string(Metrics::CacheHits).c_str());
+            ImGui::Text("Reused from cache: %s", std::to_string(Metrics::ReusedHitTests).c_str());
 
             ToggleLight();
 #ifdef _DEBUG
@@ -78,7 +78,7 @@ namespace Inferno::Editor {
                 v = ProjectRayOntoPlane(Ray(v, Args.Axis), face.Center(), face.AverageNormal());
             }
 
-            Game::Level.UpdateAllGeometricProps();
+            UpdateGeometricProps(Game::Level);
             Editor::History.SnapshotLevel("Project Geometry to Plane");
             Editor::Events::LevelChanged();
         }
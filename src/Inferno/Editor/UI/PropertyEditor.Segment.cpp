@@ -1139,7 +1139,7 @@ namespace Inferno::Editor {
         }
 
         if (changed) {
-            Game::Level.UpdateAllGeometricProps();
+            UpdateGeometricProps(Game::Level);
             Events::LevelChanged();
         }
 
@@ -69,7 +69,7 @@ namespace Inferno::Editor {
                 }
             }
 
-            Game::Level.UpdateAllGeometricProps();
+            UpdateGeometricProps(Game::Level);
             Editor::History.SnapshotLevel("Scale");
             Editor::Events::LevelChanged();
         }
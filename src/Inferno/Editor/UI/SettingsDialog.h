@@ -162,6 +162,16 @@ namespace Inferno::Editor {
                 ImGui::Checkbox("##filtering", &_graphics.HighRes);
                 ImGui::NextColumn();
 
+                ImGui::ColumnLabelEx("Compress textures", "Generates mipmaps and block compresses textures to reduce video memory.\nResults are cached in the cache folder.");
+                ImGui::Checkbox("##compress", &_graphics.CompressTextures);
+                ImGui::NextColumn();
+
+                ImGui::ColumnLabelEx("Texture budget (MB)", "Textures that aren't used by the level or recently drawn are unloaded when over this amount.\n0 is unlimited.");
+                ImGui::SetNextItemWidth(-1);
+                if (ImGui::InputInt("##texbudget", &_graphics.TextureBudget, 64, 256))
+                    _graphics.TextureBudget = std::max(_graphics.TextureBudget, 0);
+                ImGui::NextColumn();
+
                 {
                     DisableControls disable(!Render::Adapter->TypedUAVLoadSupport_R11G11B10_FLOAT());
                     ImGui::ColumnLabelEx("Bloom", "Bloom is an effect that has no impact on the level.\nCustom emissive textures are suggested to appear correctly.\n\nRequires a GPU that supports typed UAV loads");
@@ -482,7 +492,7 @@ namespace Inferno::Editor {
                 resourcesChanged = true;
             }
 
-            if (_graphics.HighRes != Settings::Graphics.HighRes) {
+            if (_graphics.HighRes != Settings::Graphics.HighRes || _graphics.CompressTextures != Settings::Graphics.CompressTextures) {
                 resourcesChanged = true;
             }
 
@@ -131,8 +131,9 @@ namespace Inferno::Editor {
                     }
                 }
                 else if (selectedGame == 2) {
-                    for (int i = 0; i < Resources::GameTable.Sounds.size(); i++) {
-                        auto& sound = Resources::GameTable.Sounds[i];
+                    auto sounds = Resources::GameTable.GetSoundPages();
+                    for (int i = 0; i < sounds.size(); i++) {
+                        auto& sound = sounds[i];
 
                         auto label = fmt::format("{}: {} ({})", i, sound.Name, sound.FileName);
 
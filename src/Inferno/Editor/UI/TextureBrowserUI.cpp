@@ -144,12 +144,15 @@ namespace Inferno::Editor {
         // Update ids immediately. They will display as loading completes.
         _textureIds.clear();
         Seq::append(_textureIds, ids);
-        Seq::insert(Render::Materials->KeepLoaded, tids); // so browser textures don't get discarded after a prune
+        Render::Materials->KeepLoaded(tids); // so browser textures don't get discarded after a prune
     }
 
     TextureBrowserUI::TextureBrowserUI() : WindowBase("Textures", &Settings::Editor.Windows.Textures) {
         Events::LevelLoaded += [this] { UpdateTextureList(_filter, true); };
-        Events::LevelChanged += [this] { UpdateTextureList(_filter, false); };
+        Events::LevelModified += [this](const LevelChangeSet& changes) {
+            if (changes.Has(LevelChangeKind::Textures | LevelChangeKind::Geometry | LevelChangeKind::Walls))
+                UpdateTextureList(_filter, false);
+        };
 
         D1Filter = ParseFilter("d1filter.txt");
         D2Filter = ParseFilter("d2filter.txt");
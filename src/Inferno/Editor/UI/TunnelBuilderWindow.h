@@ -7,7 +7,9 @@ namespace Inferno::Editor {
     class TunnelBuilderWindow final : public WindowBase {
     public:
         TunnelBuilderWindow() : WindowBase("Tunnel Builder", &Settings::Editor.Windows.TunnelBuilder) {
-            Events::LevelChanged += [this] { if (IsOpen()) UpdateTunnelPreview(); };
+            Events::LevelModified += [this](const LevelChangeSet& changes) {
+                if (IsOpen() && changes.Has(LevelChangeKind::Geometry)) UpdateTunnelPreview();
+            };
         }
 
     protected:
@@ -166,6 +166,7 @@ namespace Inferno {
             front->State = WallState::Closed;
             if (back) back->State = WallState::Closed;
             SetWallTMap(side, cside, clip, 0);
+            door.Time = -1; // Release the door
         }
     }
 
@@ -254,5 +255,7 @@ namespace Inferno {
                 }
             }
         }
+
+        level.ActiveDoors.Prune();
     }
 }
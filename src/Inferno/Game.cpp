@@ -6,6 +6,109 @@
 #include "Editor/Editor.h"
 
 namespace Inferno::Game {
+    namespace {
+        // Returns the sounds that objects, robots, weapons, effects and doors in a level can play
+        List<Sound::SoundResource> GetLevelSounds(const Inferno::Level& level) {
+            Set<SoundID> ids = { Sound::SOUND_WEAPON_HIT_DOOR };
+            Set<int> robots;
+            List<int> weapons;
+
+            auto addVClip = [&ids](VClipID id) {
+                if (id != VClipID::None) ids.insert(Resources::GetVideoClip(id).Sound);
+            };
+
+            auto addContained = [&](const ContainsData& contains) {
+                if (contains.Type == ObjectType::Robot) robots.insert(contains.ID);
+            };
+
+            for (auto& obj : level.Objects) {
+                switch (obj.Type) {
+                    case ObjectType::Robot:
+                        robots.insert(obj.ID);
+                        addContained(Resources::GetRobotInfo(obj.ID).Contains);
+                        break;
+
+                    case ObjectType::Powerup:
+                    {
+                        auto& powerup = Resources::GetPowerup(obj.ID);
+                        ids.insert(SoundID(powerup.HitSound));
+                        addVClip(powerup.VClip);
+                        break;
+                    }
+
+                    case ObjectType::Weapon: // Placed mines
+                        weapons.push_back(obj.ID);
+                        break;
+                }
+
+                addContained(obj.Contains);
+            }
+
+            // Robots made by matcens, which are activated by triggers
+            for (auto& matcen : level.Matcens) {
+                for (int i = 0; i < 64; i++) {
+                    auto flags = i < 32 ? matcen.Robots : matcen.Robots2;
+                    if (flags & (1 << (i % 32))) robots.insert(i);
+                }
+            }
+
+            for (auto& id : robots) {
+                auto& info = Resources::GetRobotInfo(id);
+                ids.insert({ info.ExplosionSound1, info.ExplosionSound2, info.SeeSound, info.AttackSound,
+                             info.ClawSound, info.TauntSound, info.DeathrollSound });
+                addVClip(info.ExplosionClip1);
+                addVClip(info.ExplosionClip2);
+                if (info.WeaponType >= 0) weapons.push_back(info.WeaponType);
+                if (info.WeaponType2 >= 0) weapons.push_back(info.WeaponType2);
+            }
+
+            // Only player weapons have a cockpit icon
+            auto& gameWeapons = Resources::GameData.Weapons;
+            for (int i = 0; i < gameWeapons.size(); i++) {
+                if (gameWeapons[i].Icon > TexID::Invalid) weapons.push_back(i);
+            }
+
+            // Weapons can release child weapons, such as smart missile blobs
+            Set<int> visited;
+            while (!weapons.empty()) {
+                auto id = weapons.back();
+                weapons.pop_back();
+                if (!Seq::inRange(gameWeapons, id) || !visited.insert(id).second) continue;
+
+                auto& weapon = gameWeapons[id];
+                ids.insert({ weapon.FlashSound, weapon.RobotHitSound, weapon.WallHitSound });
+                addVClip(weapon.FlashVClip);
+                addVClip(weapon.RobotHitVClip);
+                addVClip(weapon.WallHitVClip);
+                if (weapon.Children >= 0) weapons.push_back(weapon.Children);
+            }
+
+            // Effects on walls, including the explosion when they are destroyed
+            for (auto& seg : level.Segments) {
+                for (auto& sideId : SideIDs) {
+                    auto& side = seg.GetSide(sideId);
+                    for (auto tmap : { side.TMap, side.TMap2 }) {
+                        auto id = Resources::GetEffectClipID(tmap);
+                        if (id == EClipID::None) continue;
+
+                        auto& eclip = Resources::GetEffectClip(id);
+                        ids.insert(eclip.Sound);
+                        addVClip(eclip.DestroyedVClip);
+                    }
+                }
+            }
+
+            // Doors, including the ones opened by triggers
+            for (auto& wall : level.Walls) {
+                if (auto clip = Resources::TryGetWallClip(wall.Clip))
+                    ids.insert({ clip->OpenSound, clip->CloseSound });
+            }
+
+            ids.erase(SoundID::None);
+            return Seq::map(ids, Resources::GetSoundResource);
+        }
+    }
+
     void LoadLevel(Inferno::Level&& level) {
         Inferno::Level backup = Level;
 
@@ -24,6 +127,9 @@ namespace Inferno::Game {
             Level = std::move(level); // Move to global so resource loading works properly
             Resources::LoadLevel(Level);
 
+            Sound::Reset();
+            Sound::Precache(GetLevelSounds(Level));
+
             if (forceReload || Resources::CustomTextures.Any()) // Check for custom textures before or after load
                 Render::Materials->Unload();
 
@@ -3,11 +3,15 @@
 #include "HogFile.h"
 #include "Mission.h"
 #include "Room.h"
+#include "LevelTextureIndex.h"
 
 namespace Inferno::Game {
     // The loaded level. Only one level can be active at a time.
     inline Inferno::Level Level;
 
+    // Textures used by the sides of the loaded level
+    inline LevelTextureIndex LevelTextures;
+
     // The loaded mission. Not always present.
     inline Option<HogFile> Mission;
 
@@ -0,0 +1,518 @@
+#include "pch.h"
+#include "GameDataCache.h"
+#include "Streams.h"
+#include "FileSystem.h"
+#include "logging.h"
+#include <fstream>
+
+namespace Inferno {
+    namespace {
+        constexpr auto CACHE_ID = MakeFourCC("IGDC");
+        constexpr auto OUTRAGE_BITMAP_CACHE_ID = MakeFourCC("IOGF");
+        constexpr auto OUTRAGE_VCLIP_CACHE_ID = MakeFourCC("IOAF");
+
+        // Reads values directly out of the cache buffer
+        class CacheReader {
+            span<const ubyte> _data;
+            size_t _position = 0;
+
+        public:
+            CacheReader(span<const ubyte> data) : _data(data) {}
+
+            void ReadBytes(void* dest, size_t length) {
+                if (_position + length > _data.size())
+                    throw Exception("Unexpected end of game data cache");
+
+                memcpy(dest, _data.data() + _position, length);
+                _position += length;
+            }
+
+            template<class T>
+            T Read() {
+                static_assert(std::is_trivially_copyable_v<T>);
+                T value;
+                ReadBytes(&value, sizeof(T));
+                return value;
+            }
+
+            template<class T>
+            void ReadList(List<T>& list) {
+                static_assert(std::is_trivially_copyable_v<T>);
+                list.resize(Read<uint32>());
+                ReadBytes(list.data(), list.size() * sizeof(T));
+            }
+
+            template<class T>
+            List<T> ReadList() {
+                List<T> list;
+                ReadList(list);
+                return list;
+            }
+
+            string ReadString() {
+                string str(Read<uint32>(), '\0');
+                ReadBytes(str.data(), str.size());
+                return str;
+            }
+        };
+
+        template<class T>
+        void WriteValue(StreamWriter& writer, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            writer.WriteBytes(span((const ubyte*)&value, sizeof(T)));
+        }
+
+        template<class T>
+        void WriteList(StreamWriter& writer, const List<T>& list) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            writer.Write((uint32)list.size());
+            writer.WriteBytes(span((const ubyte*)list.data(), list.size() * sizeof(T)));
+        }
+
+        void WriteString(StreamWriter& writer, const string& str) {
+            writer.Write((uint32)str.size());
+            writer.WriteBytes(span((const ubyte*)str.data(), str.size()));
+        }
+
+        void WriteSources(StreamWriter& writer, span<const CacheSource> sources) {
+            writer.Write((uint32)sources.size());
+            for (auto& source : sources) {
+                WriteString(writer, source.Path);
+                writer.Write(source.Size);
+                writer.Write(source.WriteTime);
+            }
+        }
+
+        bool SourcesMatch(CacheReader& reader, span<const CacheSource> sources) {
+            if (reader.Read<uint32>() != sources.size()) return false;
+
+            for (auto& expected : sources) {
+                CacheSource source;
+                source.Path = reader.ReadString();
+                source.Size = reader.Read<uint64>();
+                source.WriteTime = reader.Read<int64>();
+                if (source != expected) return false;
+            }
+
+            return true;
+        }
+
+        void WriteLevelTexture(StreamWriter& writer, const LevelTexture& t) {
+            WriteValue(writer, t.Flags);
+            WriteValue(writer, t.Lighting);
+            WriteValue(writer, t.Damage);
+            WriteValue(writer, t.EffectClip);
+            WriteValue(writer, t.DestroyedTexture);
+            WriteValue(writer, t.Slide);
+            WriteValue(writer, t.ID);
+            WriteValue(writer, t.TexID);
+            WriteString(writer, t.D1FileName);
+        }
+
+        LevelTexture ReadLevelTexture(CacheReader& reader) {
+            LevelTexture t;
+            t.Flags = reader.Read<TextureFlag>();
+            t.Lighting = reader.Read<float>();
+            t.Damage = reader.Read<float>();
+            t.EffectClip = reader.Read<EClipID>();
+            t.DestroyedTexture = reader.Read<LevelTexID>();
+            t.Slide = reader.Read<Vector2>();
+            t.ID = reader.Read<LevelTexID>();
+            t.TexID = reader.Read<TexID>();
+            t.D1FileName = reader.ReadString();
+            return t;
+        }
+
+        void WriteWallClip(StreamWriter& writer, const WallClip& clip) {
+            WriteValue(writer, clip.PlayTime);
+            WriteValue(writer, clip.NumFrames);
+            WriteValue(writer, clip.Frames);
+            WriteValue(writer, clip.OpenSound);
+            WriteValue(writer, clip.CloseSound);
+            WriteValue(writer, clip.Flags);
+            WriteString(writer, clip.Filename);
+        }
+
+        WallClip ReadWallClip(CacheReader& reader) {
+            WallClip clip;
+            clip.PlayTime = reader.Read<float>();
+            clip.NumFrames = reader.Read<int16>();
+            clip.Frames = reader.Read<decltype(clip.Frames)>();
+            clip.OpenSound = reader.Read<SoundID>();
+            clip.CloseSound = reader.Read<SoundID>();
+            clip.Flags = reader.Read<WallClipFlag>();
+            clip.Filename = reader.ReadString();
+            return clip;
+        }
+
+        void WriteSubmodel(StreamWriter& writer, const Submodel& s) {
+            WriteValue(writer, s.Pointer);
+            WriteValue(writer, s.Offset);
+            WriteValue(writer, s.Normal);
+            WriteValue(writer, s.Point);
+            WriteValue(writer, s.Radius);
+            WriteValue(writer, s.Parent);
+            WriteValue(writer, s.Min);
+            WriteValue(writer, s.Max);
+
+            WriteList(writer, s.Vertices);
+
+            writer.Write((uint32)s.Indices.size());
+            for (auto& indices : s.Indices)
+                WriteList(writer, indices);
+
+            WriteList(writer, s.Glows);
+        }
+
+        Submodel ReadSubmodel(CacheReader& reader) {
+            Submodel s{};
+            s.Pointer = reader.Read<int>();
+            s.Offset = reader.Read<Vector3>();
+            s.Normal = reader.Read<Vector3>();
+            s.Point = reader.Read<Vector3>();
+            s.Radius = reader.Read<float>();
+            s.Parent = reader.Read<ubyte>();
+            s.Min = reader.Read<Vector3>();
+            s.Max = reader.Read<Vector3>();
+
+            reader.ReadList(s.Vertices);
+
+            s.Indices.resize(reader.Read<uint32>());
+            for (auto& indices : s.Indices)
+                reader.ReadList(indices);
+
+            reader.ReadList(s.Glows);
+            return s;
+        }
+
+        void WriteModel(StreamWriter& writer, const Model& model) {
+            writer.Write(model.DataSize);
+            writer.Write((uint32)model.Submodels.size());
+            for (auto& submodel : model.Submodels)
+                WriteSubmodel(writer, submodel);
+
+            WriteValue(writer, model.MinBounds);
+            WriteValue(writer, model.MaxBounds);
+            WriteValue(writer, model.Radius);
+            writer.Write(model.TextureCount);
+            writer.Write(model.FirstTexture);
+            writer.Write(model.SimplerModel);
+            WriteList(writer, model.angles);
+        }
+
+        Model ReadModel(CacheReader& reader) {
+            Model model{};
+            model.DataSize = reader.Read<uint>();
+            model.Submodels.resize(reader.Read<uint32>());
+            for (auto& submodel : model.Submodels)
+                submodel = ReadSubmodel(reader);
+
+            model.MinBounds = reader.Read<Vector3>();
+            model.MaxBounds = reader.Read<Vector3>();
+            model.Radius = reader.Read<float>();
+            model.TextureCount = reader.Read<ubyte>();
+            model.FirstTexture = reader.Read<ushort>();
+            model.SimplerModel = reader.Read<ubyte>();
+            reader.ReadList(model.angles);
+            return model;
+        }
+
+        void WriteHam(StreamWriter& writer, const HamFile& ham) {
+            WriteList(writer, ham.LevelTexIdx);
+            WriteList(writer, ham.AllTexIdx);
+
+            writer.Write((uint32)ham.TexInfo.size());
+            for (auto& t : ham.TexInfo)
+                WriteLevelTexture(writer, t);
+
+            WriteList(writer, ham.Sounds);
+            WriteList(writer, ham.AltSounds);
+            WriteList(writer, ham.VClips);
+            WriteList(writer, ham.Effects);
+
+            writer.Write((uint32)ham.WallClips.size());
+            for (auto& clip : ham.WallClips)
+                WriteWallClip(writer, clip);
+
+            WriteList(writer, ham.Robots);
+            WriteList(writer, ham.RobotJoints);
+            WriteList(writer, ham.Weapons);
+            WriteList(writer, ham.Powerups);
+
+            writer.Write((uint32)ham.Models.size());
+            for (auto& model : ham.Models)
+                WriteModel(writer, model);
+
+            WriteList(writer, ham.DyingModels);
+            WriteList(writer, ham.DeadModels);
+            WriteList(writer, ham.Gauges);
+            WriteList(writer, ham.HiResGauges);
+            WriteList(writer, ham.ObjectBitmaps);
+            WriteList(writer, ham.ObjectBitmapPointers);
+            WriteValue(writer, ham.PlayerShip);
+            WriteList(writer, ham.Cockpits);
+            writer.Write(ham.FirstMultiplayerBitmap);
+            writer.Write(ham.MarkerModel);
+            WriteList(writer, ham.Reactors);
+            writer.Write(ham.ExitModel);
+            writer.Write(ham.DestroyedExitModel);
+        }
+
+        HamFile ReadHam(CacheReader& reader) {
+            HamFile ham;
+            reader.ReadList(ham.LevelTexIdx);
+            reader.ReadList(ham.AllTexIdx);
+
+            ham.TexInfo.resize(reader.Read<uint32>());
+            for (auto& t : ham.TexInfo)
+                t = ReadLevelTexture(reader);
+
+            reader.ReadList(ham.Sounds);
+            reader.ReadList(ham.AltSounds);
+            reader.ReadList(ham.VClips);
+            reader.ReadList(ham.Effects);
+
+            ham.WallClips.resize(reader.Read<uint32>());
+            for (auto& clip : ham.WallClips)
+                clip = ReadWallClip(reader);
+
+            reader.ReadList(ham.Robots);
+            reader.ReadList(ham.RobotJoints);
+            reader.ReadList(ham.Weapons);
+            reader.ReadList(ham.Powerups);
+
+            ham.Models.resize(reader.Read<uint32>());
+            for (auto& model : ham.Models)
+                model = ReadModel(reader);
+
+            reader.ReadList(ham.DyingModels);
+            reader.ReadList(ham.DeadModels);
+            reader.ReadList(ham.Gauges);
+            reader.ReadList(ham.HiResGauges);
+            reader.ReadList(ham.ObjectBitmaps);
+            reader.ReadList(ham.ObjectBitmapPointers);
+            ham.PlayerShip = reader.Read<PlayerShip>();
+            reader.ReadList(ham.Cockpits);
+            ham.FirstMultiplayerBitmap = reader.Read<int>();
+            ham.MarkerModel = reader.Read<ModelID>();
+            reader.ReadList(ham.Reactors);
+            ham.ExitModel = reader.Read<ModelID>();
+            ham.DestroyedExitModel = reader.Read<ModelID>();
+            UpdateClipLookups(ham);
+            return ham;
+        }
+
+        void WritePigEntry(StreamWriter& writer, const PigEntry& entry) {
+            WriteString(writer, entry.Name);
+            writer.Write(entry.Width);
+            writer.Write(entry.Height);
+            writer.Write(entry.AvgColor);
+            WriteValue(writer, entry.AverageColor);
+            writer.Write(entry.DataOffset);
+            writer.Write(entry.Transparent);
+            writer.Write(entry.SuperTransparent);
+            writer.Write(entry.UsesRle);
+            writer.Write(entry.UsesBigRle);
+            writer.Write(entry.Animated);
+            writer.Write(entry.Frame);
+            writer.Write(entry.ID);
+            writer.Write(entry.Custom);
+        }
+
+        PigEntry ReadPigEntry(CacheReader& reader) {
+            PigEntry entry{};
+            entry.Name = reader.ReadString();
+            entry.Width = reader.Read<uint16>();
+            entry.Height = reader.Read<uint16>();
+            entry.AvgColor = reader.Read<ubyte>();
+            entry.AverageColor = reader.Read<Color>();
+            entry.DataOffset = reader.Read<uint32>();
+            entry.Transparent = reader.Read<bool>();
+            entry.SuperTransparent = reader.Read<bool>();
+            entry.UsesRle = reader.Read<bool>();
+            entry.UsesBigRle = reader.Read<bool>();
+            entry.Animated = reader.Read<bool>();
+            entry.Frame = reader.Read<uint8>();
+            entry.ID = reader.Read<TexID>();
+            entry.Custom = reader.Read<bool>();
+            return entry;
+        }
+
+        void WritePig(StreamWriter& writer, const PigFile& pig) {
+            WriteString(writer, filesystem::path(pig.Path).string());
+            writer.Write((uint64)pig.DataStart);
+            writer.Write((uint32)pig.Entries.size());
+            for (auto& entry : pig.Entries)
+                WritePigEntry(writer, entry);
+        }
+
+        PigFile ReadPig(CacheReader& reader) {
+            PigFile pig;
+            pig.Path = filesystem::path(reader.ReadString()).wstring();
+            pig.DataStart = reader.Read<uint64>();
+            pig.Entries.resize(reader.Read<uint32>());
+            for (auto& entry : pig.Entries)
+                entry = ReadPigEntry(reader);
+            return pig;
+        }
+
+        void WritePalette(StreamWriter& writer, const Palette& palette) {
+            WriteValue(writer, palette.SuperTransparent);
+            WriteList(writer, palette.FadeTables);
+            WriteList(writer, palette.Data);
+        }
+
+        Palette ReadPalette(CacheReader& reader) {
+            Palette palette;
+            palette.SuperTransparent = reader.Read<Palette::Color>();
+            reader.ReadList(palette.FadeTables);
+            reader.ReadList(palette.Data);
+            return palette;
+        }
+
+        void WriteOutrageBitmap(StreamWriter& writer, const Outrage::Bitmap& bitmap) {
+            WriteString(writer, bitmap.Name);
+            writer.Write((int32)bitmap.Width);
+            writer.Write((int32)bitmap.Height);
+            writer.Write((int32)bitmap.Type);
+            writer.Write((int32)bitmap.BitsPerPixel);
+            writer.Write((uint32)bitmap.Mips.size());
+            for (auto& mip : bitmap.Mips)
+                WriteList(writer, mip);
+        }
+
+        Outrage::Bitmap ReadOutrageBitmap(CacheReader& reader) {
+            Outrage::Bitmap bitmap;
+            bitmap.Name = reader.ReadString();
+            bitmap.Width = reader.Read<int32>();
+            bitmap.Height = reader.Read<int32>();
+            bitmap.Type = reader.Read<int32>();
+            bitmap.BitsPerPixel = reader.Read<int32>();
+            bitmap.Mips.resize(reader.Read<uint32>());
+            for (auto& mip : bitmap.Mips)
+                reader.ReadList(mip);
+
+            if (bitmap.Mips.empty() || bitmap.Mips[0].size() != size_t(bitmap.Width) * bitmap.Height)
+                throw Exception("Invalid bitmap size");
+
+            return bitmap;
+        }
+
+        template<class T>
+        Option<T> ReadOutrageCache(const filesystem::path& path, uint32 id, auto&& read) {
+            if (!filesystem::exists(path)) return {};
+
+            try {
+                auto data = File::ReadAllBytes(path);
+                CacheReader reader(data);
+
+                if (reader.Read<uint32>() != id || reader.Read<uint32>() != GAME_DATA_CACHE_VERSION)
+                    return {};
+
+                return read(reader);
+            }
+            catch (const std::exception& e) {
+                SPDLOG_WARN("Unable to read bitmap cache `{}`: {}", path.string(), e.what());
+                return {};
+            }
+        }
+
+        void WriteOutrageCache(const filesystem::path& path, uint32 id, auto&& write) {
+            if (path.has_parent_path())
+                filesystem::create_directories(path.parent_path());
+
+            std::ofstream stream(path, std::ios::binary);
+            StreamWriter writer(stream);
+            writer.Write(id);
+            writer.Write(GAME_DATA_CACHE_VERSION);
+            write(writer);
+        }
+    }
+
+    CacheSource GetCacheSource(const filesystem::path& path) {
+        CacheSource source;
+        source.Path = path.string();
+        source.Size = filesystem::file_size(path);
+        source.WriteTime = filesystem::last_write_time(path).time_since_epoch().count();
+        return source;
+    }
+
+    Option<GameDataCache> ReadGameDataCache(const filesystem::path& path, span<const CacheSource> sources) {
+        if (!filesystem::exists(path)) return {};
+
+        try {
+            auto data = File::ReadAllBytes(path);
+            CacheReader reader(data);
+
+            if (reader.Read<uint32>() != CACHE_ID || reader.Read<uint32>() != GAME_DATA_CACHE_VERSION)
+                return {};
+
+            if (!SourcesMatch(reader, sources))
+                return {};
+
+            GameDataCache cache;
+            cache.Ham = ReadHam(reader);
+            cache.Pig = ReadPig(reader);
+            cache.Palette = ReadPalette(reader);
+            return cache;
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to read game data cache `{}`: {}", path.string(), e.what());
+            return {};
+        }
+    }
+
+    void WriteGameDataCache(const filesystem::path& path, span<const CacheSource> sources,
+                            const HamFile& ham, const PigFile& pig, const Palette& palette) {
+        if (path.has_parent_path())
+            filesystem::create_directories(path.parent_path());
+
+        std::ofstream stream(path, std::ios::binary);
+        StreamWriter writer(stream);
+        writer.Write(CACHE_ID);
+        writer.Write(GAME_DATA_CACHE_VERSION);
+        WriteSources(writer, sources);
+        WriteHam(writer, ham);
+        WritePig(writer, pig);
+        WritePalette(writer, palette);
+    }
+
+    Option<Outrage::Bitmap> ReadOutrageBitmapCache(const filesystem::path& path) {
+        return ReadOutrageCache<Outrage::Bitmap>(path, OUTRAGE_BITMAP_CACHE_ID, [](CacheReader& reader) {
+            return ReadOutrageBitmap(reader);
+        });
+    }
+
+    Option<Outrage::VClip> ReadOutrageVClipCache(const filesystem::path& path) {
+        return ReadOutrageCache<Outrage::VClip>(path, OUTRAGE_VCLIP_CACHE_ID, [](CacheReader& reader) {
+            Outrage::VClip vclip;
+            vclip.FileName = reader.ReadString();
+            vclip.FrameTime = reader.Read<float>();
+            vclip.Version = reader.Read<int32>();
+            vclip.PingPong = reader.Read<ubyte>() != 0;
+            vclip.Frames.resize(reader.Read<uint32>());
+            for (auto& frame : vclip.Frames)
+                frame = ReadOutrageBitmap(reader);
+
+            return vclip;
+        });
+    }
+
+    void WriteOutrageBitmapCache(const filesystem::path& path, const Outrage::Bitmap& bitmap) {
+        WriteOutrageCache(path, OUTRAGE_BITMAP_CACHE_ID, [&bitmap](StreamWriter& writer) {
+            WriteOutrageBitmap(writer, bitmap);
+        });
+    }
+
+    void WriteOutrageVClipCache(const filesystem::path& path, const Outrage::VClip& vclip) {
+        WriteOutrageCache(path, OUTRAGE_VCLIP_CACHE_ID, [&vclip](StreamWriter& writer) {
+            WriteString(writer, vclip.FileName);
+            writer.Write(vclip.FrameTime);
+            writer.Write((int32)vclip.Version);
+            writer.Write((ubyte)vclip.PingPong);
+            writer.Write((uint32)vclip.Frames.size());
+            for (auto& frame : vclip.Frames)
+                WriteOutrageBitmap(writer, frame);
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "HamFile.h"
+#include "Pig.h"
+#include "OutrageBitmap.h"
+
+namespace Inferno {
+    // Increment when the layout of any cached structure changes
+    constexpr uint32 GAME_DATA_CACHE_VERSION = 2;
+
+    // A file that cached data was built from. The cache is stale if any of these change.
+    struct CacheSource {
+        string Path;
+        uint64 Size = 0;
+        int64 WriteTime = 0;
+
+        bool operator==(const CacheSource&) const = default;
+    };
+
+    // Resolved game data that is slow to parse from the original files.
+    // Pig entries include their average colors.
+    struct GameDataCache {
+        HamFile Ham;
+        PigFile Pig;
+        Inferno::Palette Palette;
+    };
+
+    // Returns the size and modified time of a file
+    CacheSource GetCacheSource(const filesystem::path& path);
+
+    // Reads a game data cache in a single read. Returns nothing if the file is missing,
+    // was written by a different version or any of the sources have changed.
+    Option<GameDataCache> ReadGameDataCache(const filesystem::path& path, span<const CacheSource> sources);
+
+    void WriteGameDataCache(const filesystem::path& path, span<const CacheSource> sources,
+                            const HamFile& ham, const PigFile& pig, const Palette& palette);
+
+    // Decoded Descent 3 bitmaps and animations. Returns nothing if the file is missing or invalid.
+    Option<Outrage::Bitmap> ReadOutrageBitmapCache(const filesystem::path& path);
+    Option<Outrage::VClip> ReadOutrageVClipCache(const filesystem::path& path);
+
+    void WriteOutrageBitmapCache(const filesystem::path& path, const Outrage::Bitmap& bitmap);
+    void WriteOutrageVClipCache(const filesystem::path& path, const Outrage::VClip& vclip);
+}
\ No newline at end of file
@@ -26,6 +26,13 @@ namespace Inferno {
         ID3D12Resource* operator->() { return _resource.Get(); }
         const ID3D12Resource* operator->() const { return _resource.Get(); }
         operator bool() { return _resource.Get() != nullptr; }
+
+        // Bytes of video memory used by the resource
+        uint64 GetAllocationSize() const {
+            if (!_resource) return 0;
+            auto desc = _resource->GetDesc();
+            return Render::Device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+        }
         void Release() {
             _resource.Reset();
         }
@@ -186,6 +193,15 @@ namespace Inferno {
             _desc = _resource->GetDesc();
             return true;
         }
+
+        // Loads a DDS file that was already read into memory
+        bool LoadDDS(DirectX::ResourceUploadBatch& batch, span<const ubyte> data) {
+            ThrowIfFailed(DirectX::CreateDDSTextureFromMemory(Render::Device, batch, data.data(), data.size(), _resource.ReleaseAndGetAddressOf()));
+            _state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE; // CreateDDS transitions state
+            batch.Transition(_resource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            _desc = _resource->GetDesc();
+            return true;
+        }
     };
 
     // Color buffer for render targets or compute shaders
@@ -211,11 +211,24 @@ namespace Inferno {
         return BlendMode::Alpha;
     }
 
+    // Returns the vertex colors of a side, including the transparency of cloaked walls
+    Array<Color, 4> GetSideLighting(Level& level, const SegmentSide& side, bool isWall) {
+        Array<Color, 4> lt = side.Light;
+
+        if (auto wall = level.TryGetWall(side.Wall); isWall && wall && wall->Type == WallType::Cloaked) {
+            auto alpha = 1 - wall->CloakValue();
+            Seq::iter(lt, [alpha](auto& x) { x.A(alpha); });
+        }
+
+        return lt;
+    }
+
     void CreateLevelGeometry(Level& level, ChunkCache& chunks, LevelGeometry& geo) {
         chunks.clear();
         geo.Chunks.clear();
         geo.Vertices.clear();
         geo.Walls.clear();
+        geo.SideVertices.assign(level.Segments.size() * 6, -1);
 
         for (int id = 0; id < level.Segments.size(); id++) {
             auto& seg = level.Segments[id];
@@ -260,18 +273,17 @@ namespace Inferno {
                 if (side.HasOverlay())
                     chunk.EffectClip2 = Resources::GetEffectClipID(side.TMap2);
 
-                Array<Color, 4> lt = side.Light;
-                
+                auto lt = GetSideLighting(level, side, isWall);
+
                 if (isWall && wall) {
                     chunk.Blend = GetWallBlendMode(level, side.TMap);
                     if (wall->Type == WallType::Cloaked) {
                         chunk.Blend = BlendMode::Alpha;
-                        auto alpha = 1 - wall->CloakValue();
-                        Seq::iter(lt, [alpha](auto& x) { x.A(alpha); });
                         chunk.Cloaked = true;
                     }
                 }
 
+                geo.SideVertices[id * 6 + (int)sideId] = (int32)geo.Vertices.size();
                 auto verts = Face::FromSide(level, seg, sideId).CopyPoints();
                 AddPolygon(verts, side.UVs, lt, geo, chunk, side);
 
@@ -358,6 +370,36 @@ namespace Inferno {
         UpdateBuffers(buffer);
     }
 
+    bool LevelMeshBuilder::UpdateSides(Level& level, const Set<Tag>& sides, PackedBuffer& buffer) {
+        if (_geometry.SideVertices.size() != level.Segments.size() * 6)
+            return false; // segments were added or removed
+
+        for (auto& tag : sides) {
+            auto seg = level.TryGetSegment(tag);
+            if (!seg || tag.Side == SideID::None) continue;
+
+            auto start = _geometry.SideVertices[(int)tag.Segment * 6 + (int)tag.Side];
+            if (start < 0) continue; // not rendered
+            if (size_t(start) + 4 > _geometry.Vertices.size()) return false;
+
+            auto& side = seg->GetSide(tag.Side);
+            auto wall = level.TryGetWall(side.Wall);
+            // wall triggers aren't really walls for the purposes of rendering
+            auto isWall = seg->SideIsWall(tag.Side) && !(wall && wall->Type == WallType::WallTrigger);
+            auto lt = GetSideLighting(level, side, isWall);
+
+            for (int i = 0; i < 4; i++) {
+                auto& vertex = _geometry.Vertices[start + i];
+                vertex.UV = side.UVs[i];
+                vertex.UV2 = side.HasOverlay() ? GetOverlayRotation(side, side.UVs[i]) : Vector2();
+                vertex.Color = lt[i];
+            }
+        }
+
+        UpdateBuffers(buffer);
+        return true;
+    }
+
     void LevelMeshBuilder::UpdateBuffers(PackedBuffer& buffer) {
         buffer.ResetIndex();
         _meshes.clear();
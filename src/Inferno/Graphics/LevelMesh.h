@@ -39,6 +39,8 @@ namespace Inferno {
         // Technically vertices are no longer needed after being uploaded
         List<LevelVertex> Vertices;
         HeatVolume HeatVolumes;
+        // First vertex of each rendered side, six per segment. -1 if the side isn't rendered.
+        List<int32> SideVertices;
     };
 
     using ChunkCache = Dictionary<uint32, LevelChunk>;
@@ -113,6 +115,9 @@ namespace Inferno {
 
         void Update(Level& level, PackedBuffer& buffer);
 
+        // Updates the UVs and lighting of sides without rebuilding the chunks.
+        // Returns false if the mesh is out of date and needs a full update.
+        bool UpdateSides(Level& level, const Set<Tag>& sides, PackedBuffer& buffer);
 
     private:
         void UpdateBuffers(PackedBuffer& buffer);
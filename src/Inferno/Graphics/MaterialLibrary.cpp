@@ -4,6 +4,7 @@
 #include "Render.h"
 #include "Game.h"
 #include "Convert.h"
+#include "ScopedTimer.h"
 
 using namespace DirectX;
 
@@ -76,6 +77,13 @@ namespace Inferno::Render {
     Set<TexID> GetLevelSegmentTextures(const Inferno::Level& level) {
         Set<TexID> ids;
 
+        if (&level == &Game::Level) {
+            // The loaded level is indexed, so only sides touched by edits since the last call are updated
+            Game::LevelTextures.Sync(level);
+            Game::LevelTextures.GetResidentTextures(ids);
+            return ids;
+        }
+
         for (auto& seg : level.Segments) {
             for (auto& sideId : SideIDs) {
                 auto& side = seg.GetSide(sideId);
@@ -150,10 +158,20 @@ namespace Inferno::Render {
         return ids;
     }
 
-    Option<Material2D> UploadMaterial(ResourceUploadBatch& batch,
-                                      MaterialUpload& upload,
-                                      Texture2D& defaultTex) {
-        if (upload.ID <= TexID::Invalid) return {};
+    // Frames a texture must go undrawn before it can be evicted
+    constexpr uint64 EVICTION_FRAME_DELAY = 120;
+
+    size_t GetMaterialSize(const Material2D& material) {
+        size_t bytes = 0;
+        for (auto& texture : material.Textures)
+            bytes += texture.GetAllocationSize();
+
+        return bytes;
+    }
+
+    Material2D UploadMaterial(ResourceUploadBatch& batch,
+                              StagedMaterial& staged,
+                              Texture2D& defaultTex) {
         Material2D material;
         material.Index = Render::Heaps->Shader.AllocateIndex();
 
@@ -161,40 +179,22 @@ namespace Inferno::Render {
         for (int i = 0; i < Material2D::Count; i++)
             material.Handles[i] = Render::Heaps->Shader.GetGpuHandle(material.Index + i);
 
-        material.Name = upload.Bitmap->Info.Name;
-        material.ID = upload.ID;
-
-        bool loadedDiffuse = false;
-        bool loadedST = false;
-
-        // remove the frame number when loading special textures, as they should share.
-        string baseName = material.Name;
-        if (auto i = baseName.find("#"); i > 0)
-            baseName = baseName.substr(0, i);
-
-        //SPDLOG_INFO("Loading texture `{}` to heap index: {}", ti->Name, material.Index);
-        if (Settings::Graphics.HighRes) {
-            if (auto path = FileSystem::TryFindFile(upload.Bitmap->Info.Name + ".DDS"))
-                loadedDiffuse = material.Textures[Material2D::Diffuse].LoadDDS(batch, *path);
+        material.Name = staged.Name;
+        material.ID = staged.ID;
 
-            if (upload.SuperTransparent)
-                if (auto path = FileSystem::TryFindFile(baseName + "_st.DDS"))
-                    loadedST = material.Textures[Material2D::SuperTransparency].LoadDDS(batch, *path);
-        }
-
-        if (!loadedDiffuse) {
-            material.Textures[Material2D::Diffuse].Load(batch, upload.Bitmap->Data.data(), upload.Bitmap->Info.Width, upload.Bitmap->Info.Height, Convert::ToWideString(upload.Bitmap->Info.Name));
-        }
+        auto upload = [&batch, &material](Texture2D& texture, const StagedTexture& source) {
+            if (!source) return;
 
-        // todo: optimize by putting all materials into a dictionary or some other way of not reloading special maps
-        if (!loadedST && upload.SuperTransparent)
-            material.Textures[Material2D::SuperTransparency].Load(batch, upload.Bitmap->Mask.data(), upload.Bitmap->Info.Width, upload.Bitmap->Info.Height, Convert::ToWideString(upload.Bitmap->Info.Name));
+            if (source.IsDDS)
+                texture.LoadDDS(batch, source.Data);
+            else
+                texture.Load(batch, source.Data.data(), source.Width, source.Height, Convert::ToWideString(material.Name));
+        };
 
-        if (auto path = FileSystem::TryFindFile(baseName + "_e.DDS"))
-            material.Textures[Material2D::Emissive].LoadDDS(batch, *path);
-
-        if (auto path = FileSystem::TryFindFile(baseName + "_s.DDS"))
-            material.Textures[Material2D::Specular].LoadDDS(batch, *path);
+        upload(material.Textures[Material2D::Diffuse], staged.Diffuse);
+        upload(material.Textures[Material2D::SuperTransparency], staged.SuperTransparency);
+        upload(material.Textures[Material2D::Emissive], staged.Emissive);
+        upload(material.Textures[Material2D::Specular], staged.Specular);
 
         for (uint i = 0; i < std::size(material.Textures); i++) {
             auto handle = Render::Heaps->Shader.GetCpuHandle(material.Index + i);
@@ -238,24 +238,14 @@ namespace Inferno::Render {
 
     protected:
         void Work() override {
-            auto batch = BeginTextureUpload();
-
             List<MaterialUpload> queuedUploads;
             _lib->_requestedUploads.ForEach([&queuedUploads](auto& x) {
                 queuedUploads.push_back(std::move(x));
             });
             _lib->_requestedUploads.Clear();
 
-            List<Material2D> uploads;
-            for (auto& upload : queuedUploads) {
-                if (!upload.Bitmap || upload.Bitmap->Info.Width == 0 || upload.Bitmap->Info.Height == 0)
-                    continue;
-
-                if (auto material = UploadMaterial(batch, upload, _lib->_black))
-                    uploads.emplace_back(std::move(material.value()));
-            }
-
-            EndTextureUpload(batch);
+            auto uploads = _lib->UploadMaterials(queuedUploads);
+            Metrics::TextureQueueDepth -= (int64)queuedUploads.size();
 
             // update pointers as textures are now loaded
             for (auto& upload : uploads) {
@@ -291,23 +281,28 @@ namespace Inferno::Render {
         // Pre-scan materials, as starting an upload batch causes a stall
         if (!forceLoad && !HasUnloadedTextures(tids)) return;
 
-        List<Material2D> uploads;
-        auto batch = BeginTextureUpload();
+        List<MaterialUpload> queuedUploads;
 
-        for (auto& id : tids) {
-            auto upload = PrepareUpload(id, forceLoad);
-            if (!upload.Bitmap || upload.Bitmap->Info.Width == 0 || upload.Bitmap->Info.Height == 0)
-                continue;
+        {
+            int64 elapsed = 0;
+            ScopedTimer timer(&elapsed);
+            for (auto& id : tids) {
+                auto upload = PrepareUpload(id, forceLoad);
+                if (upload.Bitmap) queuedUploads.push_back(std::move(upload));
+            }
 
-            if (auto material = UploadMaterial(batch, upload, _black))
-                uploads.emplace_back(std::move(material.value()));
+            Metrics::TextureGather = elapsed;
         }
 
-        SPDLOG_INFO("Loading {} textures", uploads.size());
-        EndTextureUpload(batch);
+        SPDLOG_INFO("Loading {} textures", queuedUploads.size());
+        Metrics::TextureQueueDepth += (int64)queuedUploads.size();
+        auto uploads = UploadMaterials(queuedUploads);
+        Metrics::TextureQueueDepth -= (int64)queuedUploads.size();
 
-        for (auto& upload : uploads)
+        for (auto& upload : uploads) {
+            _residency.Add(upload.ID, GetMaterialSize(upload));
             _materials[(int)upload.ID] = std::move(upload);
+        }
 
         Render::Adapter->PrintMemoryUsage();
         Render::Heaps->Shader.GetFreeDescriptors();
@@ -318,20 +313,63 @@ namespace Inferno::Render {
 
         for (auto& id : ids) {
             if (_submittedUploads.contains(id)) continue;
-            _requestedUploads.Add(PrepareUpload(id, forceLoad));
+            auto upload = PrepareUpload(id, forceLoad);
+            if (!upload.Bitmap) continue;
+
+            _requestedUploads.Add(std::move(upload));
             _submittedUploads.insert(id);
+            Metrics::TextureQueueDepth++;
         }
 
         _worker->Notify();
     }
 
+    List<Material2D> MaterialLibrary::UploadMaterials(span<const MaterialUpload> uploads) {
+        if (uploads.empty()) return {};
+
+        List<StagedMaterial> staged;
+
+        {
+            int64 elapsed = 0;
+            ScopedTimer timer(&elapsed);
+            StagingOptions options = {
+                .HighRes = Settings::Graphics.HighRes,
+                .CompressTextures = Settings::Graphics.CompressTextures
+            };
+
+            staged = StageMaterials(uploads, _stagingPool, options);
+            Metrics::TextureStage = elapsed;
+        }
+
+        List<Material2D> materials;
+
+        {
+            int64 elapsed = 0;
+            ScopedTimer timer(&elapsed);
+
+            auto batch = BeginTextureUpload();
+            for (auto& material : staged)
+                materials.push_back(UploadMaterial(batch, material, _black));
+
+            // The batch copies the data into upload buffers, so staging memory can be reused
+            ReleaseStagedMaterials(staged, _stagingPool);
+            EndTextureUpload(batch);
+            Metrics::TextureUpload = elapsed;
+        }
+
+        return materials;
+    }
+
     MaterialUpload MaterialLibrary::PrepareUpload(TexID id, bool forceLoad) {
         auto ti = Resources::TryGetTextureInfo(id);
         if (!ti) return {};
         if (!forceLoad && _materials[(int)id].ID == id) return {};
 
+        auto& bitmap = Resources::GetBitmap(id);
+        if (bitmap.Info.Width == 0 || bitmap.Info.Height == 0) return {};
+
         MaterialUpload upload;
-        upload.Bitmap = &Resources::GetBitmap(id);
+        upload.Bitmap = &bitmap;
         upload.ID = id;
         upload.SuperTransparent = ti->SuperTransparent;
         return upload;
@@ -364,6 +402,7 @@ namespace Inferno::Render {
                     if (_materials[id].ID > TexID::Invalid)
                         trash.push_back(std::move(_materials[id])); // Dispose old texture if it was loaded
 
+                    _residency.Add(pending.ID, GetMaterialSize(pending));
                     _materials[id] = std::move(pending);
                     _submittedUploads.erase(pending.ID);
                 });
@@ -384,15 +423,61 @@ namespace Inferno::Render {
         }
 
         if (_requestPrune) PruneInternal();
+
+        if (!_reloads.empty()) {
+            auto reloads = Seq::ofSet(_reloads);
+            _reloads.clear();
+            LoadMaterialsAsync(reloads);
+        }
+
+        EvictInternal();
+        _residency.NextFrame();
+    }
+
+    void MaterialLibrary::EvictInternal() {
+        _residency.SetBudget(size_t(Settings::Graphics.TextureBudget) * 1024 * 1024);
+
+        List<Material2D> trash;
+
+        for (auto& id : _residency.Evict(EVICTION_FRAME_DELAY)) {
+            auto& material = _materials[(int)id];
+            if (material.ID != id) continue;
+            trash.emplace_back(std::move(material));
+            material = {}; // mark the material as unused
+        }
+
+        TrashTextures(std::move(trash));
+
+        auto& stats = _residency.GetStats();
+        Metrics::TextureResidentBytes = (int64)stats.ResidentBytes;
+        Metrics::TextureEvictions = stats.Evictions;
+        Metrics::TextureReloadMisses = stats.ReloadMisses;
     }
 
     void MaterialLibrary::LoadLevelTextures(const Inferno::Level& level, bool force) {
         SPDLOG_INFO("Load level textures. Force {}", force);
         Render::Adapter->WaitForGpu();
-        KeepLoaded.clear();
-        auto ids = GetLevelTextures(level, PreloadDoors);
-        auto tids = Seq::ofSet(ids);
+        _keepLoaded.clear();
+
+        int64 elapsed = 0;
+        List<TexID> tids;
+
+        {
+            ScopedTimer timer(&elapsed);
+            auto ids = GetLevelTextures(level, PreloadDoors);
+            tids = Seq::ofSet(ids);
+            _residency.SetPinned(std::move(ids));
+        }
+
         LoadMaterials(tids, force);
+        Metrics::TextureGather += elapsed;
+    }
+
+    void MaterialLibrary::KeepLoaded(span<const TexID> ids) {
+        for (auto& id : ids) {
+            _keepLoaded.insert(id);
+            _residency.Pin(id);
+        }
     }
 
     void MaterialLibrary::LoadOutrageModel(const Outrage::Model& model) {
@@ -432,17 +517,19 @@ namespace Inferno::Render {
 
     void MaterialLibrary::PruneInternal() {
         auto ids = GetLevelTextures(Game::Level, PreloadDoors);
-        Seq::insert(ids, KeepLoaded);
+        Seq::insert(ids, _keepLoaded);
 
         List<Material2D> trash;
 
-        _materials.ForEach([&trash, &ids](auto& material) {
+        _materials.ForEach([this, &trash, &ids](auto& material) {
             if (material.ID <= TexID::Invalid || ids.contains(material.ID)) return;
+            _residency.Remove(material.ID);
             trash.emplace_back(std::move(material));
             material = {}; // mark the material as unused
         });
 
         TrashTextures(std::move(trash));
+        _residency.SetPinned(std::move(ids));
         _requestPrune = false;
     }
 
@@ -457,6 +544,7 @@ namespace Inferno::Render {
         });
 
         TrashTextures(std::move(trash));
+        _residency.Clear();
     }
 
     constexpr void FillTexture(span<ubyte> data, ubyte red, ubyte green, ubyte blue, ubyte alpha) {
@@ -8,6 +8,8 @@
 #include "Concurrent.h"
 #include "OutrageBitmap.h"
 #include "OutrageModel.h"
+#include "TexturePipeline.h"
+#include "ResidencyTracker.h"
 
 namespace Inferno::Render {
     struct Material2D {
@@ -22,14 +24,6 @@ namespace Inferno::Render {
         string Name;
     };
 
-    struct MaterialUpload {
-        TexID ID = TexID::None;
-        const PigBitmap* Bitmap;
-        bool SuperTransparent = false;
-        bool ForceLoad = false;
-        Outrage::Bitmap Outrage;
-    };
-
     // Supports loading and unloading materials
     class MaterialLibrary {
         Material2D _defaultMaterial;
@@ -40,6 +34,10 @@ namespace Inferno::Render {
         ConcurrentList<MaterialUpload> _requestedUploads;
         Dictionary<string, Material2D> _outrageMaterials;
         Set<TexID> _submittedUploads; // textures submitted for async processing. Used to filter future requests.
+        StagingPool _stagingPool;
+        mutable ResidencyTracker<TexID> _residency; // Tracks memory and usage to unload textures when over budget
+        mutable Set<TexID> _reloads; // Evicted textures that were drawn and need to be loaded again
+        Set<TexID> _keepLoaded; // Materials to keep loaded after a prune
 
         Ptr<WorkerThread> _worker;
         friend class MaterialUploadWorker;
@@ -56,6 +54,7 @@ namespace Inferno::Render {
         // Returns the starting GPU handle for the material
         const Material2D& Get(TexID id) const {
             if ((int)id > _materials.Size()) return _defaultMaterial;
+            if (_residency.Touch(id)) _reloads.insert(id);
             auto& material = _materials[(int)id];
             return material.ID > TexID::Invalid ? material : _defaultMaterial;
         }
@@ -82,12 +81,18 @@ namespace Inferno::Render {
         void Prune() { _requestPrune = true; }
         void Unload();
 
-        // Materials to keep loaded after a prune
-        Set<TexID> KeepLoaded;
+        const ResidencyStats& GetResidencyStats() const { return _residency.GetStats(); }
+
+        // Keeps materials loaded after a prune and prevents them from being evicted. Cleared when a level is loaded.
+        void KeepLoaded(span<const TexID> ids);
 
     private:
         MaterialUpload PrepareUpload(TexID id, bool forceLoad);
+        // Stages the uploads on the CPU and then copies them to the GPU in a single batch
+        List<Material2D> UploadMaterials(span<const MaterialUpload> uploads);
         void PruneInternal();
+        // Unloads the least recently used textures when over the memory budget
+        void EvictInternal();
 
         bool HasUnloadedTextures(span<const TexID> tids) {
             bool hasPending = false;
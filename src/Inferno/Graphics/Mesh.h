@@ -47,32 +47,16 @@ namespace Inferno::Render {
             auto& model = Resources::GetModel(id);
 
             for (int smIndex = 0; auto & submodel : model.Submodels) {
-                int vertexCount = (int)submodel.ExpandedPoints.size();
-                assert(vertexCount % 3 == 0);
                 List<ObjectVertex> verts;
-                verts.reserve(vertexCount);
+                verts.reserve(submodel.Vertices.size());
 
-                // load vertex buffer
-                for (int i = 0; i < vertexCount; i++) {
-                    // combine points and uvs into vertices
-                    auto& uv = i >= submodel.UVs.size() ? Vector3() : submodel.UVs[i];
-                    verts.emplace_back(ObjectVertex{ submodel.ExpandedPoints[i], Vector2{ uv.x, uv.y }, submodel.ExpandedColors[i] });
-                }
-
-                // calculate normals
-                for (int i = 0; i < vertexCount; i += 3) {
-                    // create vectors for two edges and cross to get normal
-                    auto v1 = verts[i + 1].Position - verts[i].Position;
-                    auto v2 = verts[i + 2].Position - verts[i].Position;
-                    auto normal = v1.Cross(v2);
-                    normal.Normalize();
-                    verts[i].Normal = verts[i + 1].Normal = verts[i + 2].Normal = normal;
-                }
+                for (auto& v : submodel.Vertices)
+                    verts.push_back({ v.Position, v.UV, v.Color, v.Normal });
 
                 auto vertexView = _buffer.PackVertices(verts);
 
                 // Create meshes
-                for (int16 slot = 0; auto & indices : submodel.ExpandedIndices) {
+                for (int16 slot = 0; auto & indices : submodel.Indices) {
                     if (indices.size() != 0) { // don't upload empty indices
                         auto& mesh = _meshes.emplace_back();
                         handle.Meshes[smIndex][slot] = &mesh;
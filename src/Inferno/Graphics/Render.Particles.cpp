@@ -1,12 +1,13 @@
 #include "pch.h"
 #include "Render.Particles.h"
-#include "DataPool.h"
 #include "Render.h"
 
 namespace Inferno::Render {
-    //using namespace DirectX;
-
-    DataPool<Particle> Particles(Particle::IsAlive, 100);
+    namespace {
+        ParticleBuffer Particles;
+        List<ObjectVertex> ParticleVertices;
+        List<SpriteBatch> ParticleBatches;
+    }
 
     void AddParticle(Particle& p, bool randomRotation) {
         auto& vclip = Resources::GetVideoClip(p.Clip);
@@ -18,54 +19,40 @@ namespace Inferno::Render {
     }
 
     void UpdateParticles(float dt) {
-        for (auto& p : Particles) {
-            if (!Particle::IsAlive(p)) continue;
-            p.Life -= dt;
-        }
+        Particles.Update(dt);
     }
 
     void DrawParticles(ID3D12GraphicsCommandList* cmd) {
-        //auto& effect = Effects->SpriteAdditive;
-        //effect.Apply(cmd);
-        //effect.Shader->SetWorldViewProjection(cmd, ViewProjection);
-        //auto sampler = Render::GetClampedTextureSampler();
-        //effect.Shader->SetSampler(cmd, sampler);
-
-        for (auto& p : Particles) {
-            if (!Particle::IsAlive(p)) continue;
-            auto& vclip = Resources::GetVideoClip(p.Clip);
-            auto elapsed = vclip.PlayTime - p.Life;
-
-            auto* up = p.Up == Vector3::Zero ? nullptr : &p.Up;
-            DrawVClip(cmd, vclip, p.Position, p.Radius, p.Color, elapsed, true, p.Rotation, up);
-
-            //auto frame = vclip.NumFrames - (int)(elapsed / vclip.FrameTime) % vclip.NumFrames - 1;
-            //auto tid = vclip.Frames[frame];
-            //auto billboard = Matrix::CreateRotationZ(p.Rotation) * Matrix::CreateBillboard(p.Position, Camera.Position, Camera.Up);
-
-            //// create quad and transform it
-            //auto& ti = Resources::GetTextureInfo(tid);
-            //auto ratio = (float)ti.Height / (float)ti.Width;
-            //const auto r = p.Radius;
-            //const auto h = r * ratio;
-            //const auto w = r;
-            //auto p0 = Vector3::Transform({ -w, h, 0 }, billboard); // bl
-            //auto p1 = Vector3::Transform({ w, h, 0 }, billboard); // br
-            //auto p2 = Vector3::Transform({ w, -h, 0 }, billboard); // tr
-            //auto p3 = Vector3::Transform({ -w, -h, 0 }, billboard); // tl
-
-            //ObjectVertex v0(p0, { 0, 0 }, p.Color);
-            //ObjectVertex v1(p1, { 1, 0 }, p.Color);
-            //ObjectVertex v2(p2, { 1, 1 }, p.Color);
-            //ObjectVertex v3(p3, { 0, 1 }, p.Color);
-
-            //auto& material = Materials->Get(tid);
-            //effect.Shader->SetDiffuse(cmd, material.Handles[0]);
-
-            //DrawCalls++;
-            //g_SpriteBatch->Begin(cmd);
-            //g_SpriteBatch->DrawQuad(v0, v1, v2, v3);
-            //g_SpriteBatch->End();
+        auto getFrame = [](VClipID id, float elapsed) -> SpriteFrame {
+            auto& vclip = Resources::GetVideoClip(id);
+            if (vclip.NumFrames == 0) return {};
+
+            auto frame = vclip.NumFrames - (int)std::floor(elapsed / vclip.FrameTime) % vclip.NumFrames - 1;
+            auto tid = vclip.Frames[frame];
+            auto& ti = Resources::GetTextureInfo(tid);
+            return { tid, (float)ti.Height / (float)ti.Width };
+        };
+
+        Particles.BuildBatches(Camera.Position, Camera.Up, getFrame, ParticleVertices, ParticleBatches);
+        if (ParticleBatches.empty()) return;
+
+        auto& effect = Effects->SpriteAdditive;
+        effect.Apply(cmd);
+        effect.Shader->SetWorldViewProjection(cmd, ViewProjection);
+        effect.Shader->SetSampler(cmd, Render::GetClampedTextureSampler());
+
+        // One draw per texture
+        for (auto& batch : ParticleBatches) {
+            auto& material = Materials->Get(batch.Texture);
+            effect.Shader->SetDiffuse(cmd, material.Handles[0]);
+
+            DrawCalls++;
+            g_SpriteBatch->Begin(cmd);
+            for (uint32 i = batch.Start; i < batch.Start + batch.Count; i++) {
+                auto v = &ParticleVertices[i * 4];
+                g_SpriteBatch->DrawQuad(v[0], v[1], v[2], v[3]);
+            }
+            g_SpriteBatch->End();
         }
     }
-}
+}
\ No newline at end of file
@@ -26,9 +26,11 @@ namespace Inferno::Render {
     Color ClearColor = { 0.1f, 0.1f, 0.1f, 1.0f };
     BoundingFrustum CameraFrustum;
     bool LevelChanged = false;
+    Set<Tag> LevelSideChanges; // Sides with UV or lighting changes that can be updated without rebuilding the mesh
 
     //const string TEST_MODEL = "robottesttube(orbot).OOF"; // mixed transparency test
     const string TEST_MODEL = "gyro.OOF";
+    Resources::OutrageModelID TestModel = Resources::OutrageModelID::None; // Interned when a level is loaded
 
     // Dynamic render batches
     // Usage: Batch vertices / indices then use returned structs to render later
@@ -244,7 +246,7 @@ namespace Inferno::Render {
         Matrix transform = object.GetTransform();
         transform.Forward(-transform.Forward()); // flip z axis to correct for LH models
 
-        auto model = Resources::GetOutrageModel(TEST_MODEL);
+        auto model = Resources::GetOutrageModel(TestModel);
         if (model == nullptr) return;
 
         for (int submodelIndex = 0; submodelIndex < model->Submodels.size(); submodelIndex++) {
@@ -479,7 +481,21 @@ namespace Inferno::Render {
         Camera.SetViewport((float)width, (float)height);
         _levelMeshBuffer = MakePtr<PackedBuffer>(1024 * 1024 * 10);
 
-        Editor::Events::LevelChanged += [] { LevelChanged = true; };
+        Editor::Events::LevelModified += [](const Editor::LevelChangeSet& changes) {
+            using Kind = Editor::LevelChangeKind;
+            if (changes.HasOnly(Kind::Objects)) return; // objects aren't part of the level mesh
+
+            if (!changes.WholeLevel && changes.HasOnly(Kind::UVs | Kind::Lighting | Kind::Objects)) {
+                Seq::insert(LevelSideChanges, changes.Sides);
+                for (auto& seg : changes.Segments)
+                    for (auto& side : SideIDs)
+                        LevelSideChanges.insert({ seg, side });
+            }
+            else {
+                LevelChanged = true;
+            }
+        };
+
         Editor::Events::TexturesChanged += [] {
             //PendingTextures.push_back(id);
             Materials->LoadLevelTextures(Game::Level, false);
@@ -573,7 +589,8 @@ namespace Inferno::Render {
                 _meshBuffer->LoadModel(obj.Render.Model.ID);
 
         {
-            if (auto model = Resources::GetOutrageModel(TEST_MODEL)) {
+            TestModel = Resources::LoadOutrageModel(TEST_MODEL);
+            if (auto model = Resources::GetOutrageModel(TestModel)) {
                 _meshBuffer->LoadOutrageModel(*model, 0);
                 Materials->LoadOutrageModel(*model);
             }
@@ -755,6 +772,14 @@ namespace Inferno::Render {
             Adapter->WaitForGpu();
             _levelMeshBuilder.Update(Game::Level, *_levelMeshBuffer);
             LevelChanged = false;
+            LevelSideChanges.clear();
+        }
+        else if (!LevelSideChanges.empty()) {
+            Adapter->WaitForGpu();
+            if (!_levelMeshBuilder.UpdateSides(Game::Level, LevelSideChanges, *_levelMeshBuffer))
+                _levelMeshBuilder.Update(Game::Level, *_levelMeshBuffer);
+
+            LevelSideChanges.clear();
         }
 
         ScopedTimer levelTimer(&Metrics::QueueLevel);
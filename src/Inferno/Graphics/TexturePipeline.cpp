@@ -0,0 +1,118 @@
+#include "pch.h"
+#include "TexturePipeline.h"
+#include "FileSystem.h"
+#include "TextureProcessing.h"
+#include <execution>
+#include <fstream>
+
+namespace Inferno::Render {
+    List<ubyte> StagingPool::Acquire(size_t size) {
+        List<ubyte> buffer;
+
+        {
+            std::scoped_lock lock(_lock);
+            if (!_buffers.empty()) {
+                buffer = std::move(_buffers.back());
+                _buffers.pop_back();
+            }
+        }
+
+        buffer.resize(size);
+        return buffer;
+    }
+
+    void StagingPool::Release(List<ubyte>&& buffer) {
+        if (buffer.capacity() == 0) return;
+
+        std::scoped_lock lock(_lock);
+        if (_buffers.size() < MAX_BUFFERS)
+            _buffers.push_back(std::move(buffer));
+    }
+
+    size_t StagingPool::Count() {
+        std::scoped_lock lock(_lock);
+        return _buffers.size();
+    }
+
+    namespace {
+        bool StageDDS(StagedTexture& texture, const string& fileName, StagingPool& pool) {
+            auto path = FileSystem::TryFindFile(fileName);
+            if (!path) return false;
+
+            std::ifstream stream(*path, std::ios::binary);
+            auto size = filesystem::file_size(*path);
+            texture.Data = pool.Acquire(size);
+            stream.read((char*)texture.Data.data(), size);
+            texture.IsDDS = true;
+            return true;
+        }
+
+        void StagePixels(StagedTexture& texture, const PigBitmap& bitmap, span<const Palette::Color> pixels, StagingPool& pool) {
+            texture.Data = pool.Acquire(pixels.size_bytes());
+            memcpy(texture.Data.data(), pixels.data(), pixels.size_bytes());
+            texture.Width = bitmap.Info.Width;
+            texture.Height = bitmap.Info.Height;
+        }
+
+        // Generates mips and compresses the pixels into a DDS
+        void StageProcessed(StagedTexture& texture, const PigBitmap& bitmap, span<const Palette::Color> pixels,
+                            const TextureProcessOptions& options, StagingPool& pool) {
+            texture.Data = pool.Acquire(0);
+            ProcessTextureCached(pixels, bitmap.Info.Width, bitmap.Info.Height, options, texture.Data);
+            texture.Width = bitmap.Info.Width;
+            texture.Height = bitmap.Info.Height;
+            texture.IsDDS = true;
+        }
+
+        StagedMaterial StageMaterial(const MaterialUpload& upload, StagingPool& pool, const StagingOptions& options) {
+            auto& bitmap = *upload.Bitmap;
+
+            StagedMaterial staged;
+            staged.ID = upload.ID;
+            staged.Name = bitmap.Info.Name;
+
+            // remove the frame number when loading special textures, as they should share.
+            string baseName = staged.Name;
+            if (auto i = baseName.find("#"); i != string::npos)
+                baseName = baseName.substr(0, i);
+
+            auto stagePixels = [&](StagedTexture& texture, span<const Palette::Color> pixels, bool gammaCorrect) {
+                if (options.CompressTextures)
+                    StageProcessed(texture, bitmap, pixels, { .GammaCorrect = gammaCorrect }, pool);
+                else
+                    StagePixels(texture, bitmap, pixels, pool);
+            };
+
+            if (!options.HighRes || !StageDDS(staged.Diffuse, staged.Name + ".DDS", pool))
+                stagePixels(staged.Diffuse, bitmap.Data, true);
+
+            if (upload.SuperTransparent) {
+                if (!options.HighRes || !StageDDS(staged.SuperTransparency, baseName + "_st.DDS", pool))
+                    stagePixels(staged.SuperTransparency, bitmap.Mask, false);
+            }
+
+            StageDDS(staged.Emissive, baseName + "_e.DDS", pool);
+            StageDDS(staged.Specular, baseName + "_s.DDS", pool);
+            return staged;
+        }
+    }
+
+    List<StagedMaterial> StageMaterials(span<const MaterialUpload> uploads, StagingPool& pool, const StagingOptions& options) {
+        List<StagedMaterial> staged(uploads.size());
+
+        std::transform(std::execution::par, uploads.begin(), uploads.end(), staged.begin(), [&pool, &options](const MaterialUpload& upload) {
+            return StageMaterial(upload, pool, options);
+        });
+
+        return staged;
+    }
+
+    void ReleaseStagedMaterials(span<StagedMaterial> materials, StagingPool& pool) {
+        for (auto& material : materials) {
+            pool.Release(std::move(material.Diffuse.Data));
+            pool.Release(std::move(material.SuperTransparency.Data));
+            pool.Release(std::move(material.Emissive.Data));
+            pool.Release(std::move(material.Specular.Data));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include "Types.h"
+#include "Pig.h"
+#include "OutrageBitmap.h"
+
+// CPU stages of loading materials. Nothing here accesses the GPU.
+namespace Inferno::Render {
+    struct MaterialUpload {
+        TexID ID = TexID::None;
+        const PigBitmap* Bitmap;
+        bool SuperTransparent = false;
+        bool ForceLoad = false;
+        Outrage::Bitmap Outrage;
+    };
+
+    // Recycles CPU memory used to hold textures until they are copied to the GPU
+    class StagingPool {
+        std::mutex _lock;
+        List<List<ubyte>> _buffers;
+        static constexpr size_t MAX_BUFFERS = 256;
+
+    public:
+        // Returns a buffer of the requested size. Contents are undefined.
+        List<ubyte> Acquire(size_t size);
+        void Release(List<ubyte>&& buffer);
+        size_t Count();
+    };
+
+    struct StagedTexture {
+        List<ubyte> Data; // RGBA8 pixels or the contents of a DDS file
+        uint Width = 0, Height = 0;
+        bool IsDDS = false;
+
+        explicit operator bool() const { return !Data.empty(); }
+    };
+
+    // The textures of a material, ready to be copied to the GPU
+    struct StagedMaterial {
+        TexID ID = TexID::None;
+        string Name;
+        StagedTexture Diffuse, SuperTransparency, Emissive, Specular;
+    };
+
+    struct StagingOptions {
+        bool HighRes = false; // Use DDS replacements when found
+        bool CompressTextures = false; // Generate mips and block compress textures without a DDS replacement
+    };
+
+    // Reads and decodes the textures for each upload in parallel
+    List<StagedMaterial> StageMaterials(span<const MaterialUpload> uploads, StagingPool& pool, const StagingOptions& options);
+
+    // Returns the memory of staged materials to the pool
+    void ReleaseStagedMaterials(span<StagedMaterial> materials, StagingPool& pool);
+}
+
+namespace Inferno::Render::Metrics {
+    inline std::atomic<int64> TextureQueueDepth; // Textures requested but not uploaded yet
+    // Microseconds spent in each stage of the last texture batch
+    inline std::atomic<int64> TextureGather, TextureStage, TextureUpload;
+    inline std::atomic<int64> TextureResidentBytes, TextureEvictions, TextureReloadMisses;
+}
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include "pch.h"
+#include "TextureProcessing.h"
+#include "Utility.h"
+#include "logging.h"
+#include <fstream>
+#include <thread>
+
+using namespace DirectX;
+
+namespace Inferno::Render {
+    namespace {
+        // Increment when the output changes to invalidate cached textures
+        constexpr uint32 PROCESS_VERSION = 1;
+        const filesystem::path TEXTURE_CACHE_FOLDER = "cache/textures";
+
+        struct Image {
+            uint Width = 0, Height = 0;
+            List<Palette::Color> Pixels;
+
+            const Palette::Color& Get(uint x, uint y) const {
+                // Clamp to support mips smaller than a block
+                x = std::min(x, Width - 1);
+                y = std::min(y, Height - 1);
+                return Pixels[y * Width + x];
+            }
+        };
+
+        const auto SRGB_TO_LINEAR = [] {
+            Array<float, 256> table{};
+            for (int i = 0; i < 256; i++) {
+                auto c = i / 255.0f;
+                table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return table;
+        }();
+
+        float LinearToSrgb(float c) {
+            c = std::clamp(c, 0.0f, 1.0f);
+            return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1 / 2.4f) - 0.055f;
+        }
+
+        float SrgbToLinear(float c) {
+            c = std::clamp(c, 0.0f, 1.0f);
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        ubyte ToByte(float c) {
+            return (ubyte)std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f);
+        }
+
+        // Box filters an image to half size. Colors are premultiplied by alpha.
+        Image Downsample(const Image& src, bool gammaCorrect) {
+            Image dst;
+            dst.Width = std::max(src.Width / 2, 1u);
+            dst.Height = std::max(src.Height / 2, 1u);
+            dst.Pixels.resize(dst.Width * dst.Height);
+
+            for (uint y = 0; y < dst.Height; y++) {
+                for (uint x = 0; x < dst.Width; x++) {
+                    float r = 0, g = 0, b = 0, a = 0;
+
+                    for (uint i = 0; i < 4; i++) {
+                        auto& c = src.Get(x * 2 + i % 2, y * 2 + i / 2);
+                        if (c.a == 0) continue;
+
+                        if (gammaCorrect) {
+                            // Unpremultiply, filter in linear space, then weight by alpha
+                            auto alpha = c.a / 255.0f;
+                            if (c.a == 255) {
+                                r += SRGB_TO_LINEAR[c.r];
+                                g += SRGB_TO_LINEAR[c.g];
+                                b += SRGB_TO_LINEAR[c.b];
+                            }
+                            else {
+                                r += SrgbToLinear(c.r / 255.0f / alpha) * alpha;
+                                g += SrgbToLinear(c.g / 255.0f / alpha) * alpha;
+                                b += SrgbToLinear(c.b / 255.0f / alpha) * alpha;
+                            }
+                            a += alpha;
+                        }
+                        else {
+                            r += c.r / 255.0f;
+                            g += c.g / 255.0f;
+                            b += c.b / 255.0f;
+                            a += c.a / 255.0f;
+                        }
+                    }
+
+                    auto& dest = dst.Pixels[y * dst.Width + x];
+                    if (a <= 0) {
+                        dest = { 0, 0, 0, 0 };
+                    }
+                    else if (gammaCorrect) {
+                        auto alpha = a / 4;
+                        dest.r = ToByte(LinearToSrgb(r / a) * alpha);
+                        dest.g = ToByte(LinearToSrgb(g / a) * alpha);
+                        dest.b = ToByte(LinearToSrgb(b / a) * alpha);
+                        dest.a = ToByte(alpha);
+                    }
+                    else {
+                        dest = { ToByte(r / 4), ToByte(g / 4), ToByte(b / 4), ToByte(a / 4) };
+                    }
+                }
+            }
+
+            return dst;
+        }
+
+        uint16 To565(XMVECTOR color) {
+            XMFLOAT3 c;
+            XMStoreFloat3(&c, XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255)));
+            auto r = (uint16)std::lround(c.x * 31 / 255);
+            auto g = (uint16)std::lround(c.y * 63 / 255);
+            auto b = (uint16)std::lround(c.z * 31 / 255);
+            return uint16(r << 11 | g << 5 | b);
+        }
+
+        XMVECTOR From565(uint16 c) {
+            auto r = float((c >> 11) & 31);
+            auto g = float((c >> 5) & 63);
+            auto b = float(c & 31);
+            return XMVectorSet(r * 255 / 31, g * 255 / 63, b * 255 / 31, 0);
+        }
+
+        void WriteUInt16(ubyte* dest, uint16 value) {
+            dest[0] = ubyte(value);
+            dest[1] = ubyte(value >> 8);
+        }
+
+        // Encodes a 4x4 block using BC1 four color mode. Endpoints are fit along the principal axis of the colors.
+        void EncodeColorBlock(const Array<Palette::Color, 16>& block, ubyte* dest) {
+            Array<XMVECTOR, 16> colors;
+            auto mean = XMVectorZero();
+
+            for (int i = 0; i < 16; i++) {
+                colors[i] = XMVectorSet(block[i].r, block[i].g, block[i].b, 0);
+                mean = XMVectorAdd(mean, colors[i]);
+            }
+
+            mean = XMVectorScale(mean, 1 / 16.0f);
+
+            // Covariance of the colors
+            float cov[6]{};
+            for (auto& color : colors) {
+                XMFLOAT3 d;
+                XMStoreFloat3(&d, XMVectorSubtract(color, mean));
+                cov[0] += d.x * d.x;
+                cov[1] += d.x * d.y;
+                cov[2] += d.x * d.z;
+                cov[3] += d.y * d.y;
+                cov[4] += d.y * d.z;
+                cov[5] += d.z * d.z;
+            }
+
+            // Power iteration to find the principal axis
+            auto axis = XMVectorSet(1, 1, 1, 0);
+            for (int i = 0; i < 8; i++) {
+                XMFLOAT3 v;
+                XMStoreFloat3(&v, axis);
+                axis = XMVectorSet(cov[0] * v.x + cov[1] * v.y + cov[2] * v.z,
+                                   cov[1] * v.x + cov[3] * v.y + cov[4] * v.z,
+                                   cov[2] * v.x + cov[4] * v.y + cov[5] * v.z, 0);
+
+                auto length = XMVectorGetX(XMVector3Length(axis));
+                if (length < 0.0001f) {
+                    axis = XMVectorSet(1, 1, 1, 0);
+                    break;
+                }
+
+                axis = XMVectorScale(axis, 1 / length);
+            }
+
+            axis = XMVector3Normalize(axis);
+
+            float minProj = FLT_MAX, maxProj = -FLT_MAX;
+            for (auto& color : colors) {
+                auto proj = XMVectorGetX(XMVector3Dot(XMVectorSubtract(color, mean), axis));
+                minProj = std::min(minProj, proj);
+                maxProj = std::max(maxProj, proj);
+            }
+
+            auto c0 = To565(XMVectorMultiplyAdd(axis, XMVectorReplicate(maxProj), mean));
+            auto c1 = To565(XMVectorMultiplyAdd(axis, XMVectorReplicate(minProj), mean));
+            if (c0 < c1) std::swap(c0, c1);
+
+            uint32 indices = 0;
+
+            if (c0 != c1) {
+                XMVECTOR palette[4];
+                palette[0] = From565(c0);
+                palette[1] = From565(c1);
+                palette[2] = XMVectorLerp(palette[0], palette[1], 1 / 3.0f);
+                palette[3] = XMVectorLerp(palette[0], palette[1], 2 / 3.0f);
+
+                for (int i = 0; i < 16; i++) {
+                    uint32 best = 0;
+                    float bestDist = FLT_MAX;
+
+                    for (uint32 p = 0; p < 4; p++) {
+                        auto dist = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(colors[i], palette[p])));
+                        if (dist < bestDist) {
+                            bestDist = dist;
+                            best = p;
+                        }
+                    }
+
+                    indices |= best << (i * 2);
+                }
+            }
+
+            WriteUInt16(dest, c0);
+            WriteUInt16(dest + 2, c1);
+            memcpy(dest + 4, &indices, sizeof indices);
+        }
+
+        // Encodes the alpha of a 4x4 block using the eight value mode of BC3
+        void EncodeAlphaBlock(const Array<Palette::Color, 16>& block, ubyte* dest) {
+            ubyte a0 = 0, a1 = 255;
+            for (auto& c : block) {
+                a0 = std::max(a0, c.a);
+                a1 = std::min(a1, c.a);
+            }
+
+            uint64 indices = 0;
+
+            if (a0 != a1) {
+                int palette[8] = { a0, a1 };
+                for (int i = 1; i < 7; i++)
+                    palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+                for (int i = 0; i < 16; i++) {
+                    uint64 best = 0;
+                    int bestDist = INT_MAX;
+
+                    for (int p = 0; p < 8; p++) {
+                        auto dist = std::abs(block[i].a - palette[p]);
+                        if (dist < bestDist) {
+                            bestDist = dist;
+                            best = p;
+                        }
+                    }
+
+                    indices |= best << (i * 3);
+                }
+            }
+
+            dest[0] = a0;
+            dest[1] = a1;
+            for (int i = 0; i < 6; i++)
+                dest[2 + i] = ubyte(indices >> (i * 8));
+        }
+
+        void CompressImage(const Image& image, bool hasAlpha, List<ubyte>& dest) {
+            auto blocksX = (image.Width + 3) / 4;
+            auto blocksY = (image.Height + 3) / 4;
+            auto blockSize = hasAlpha ? 16 : 8;
+            auto offset = dest.size();
+            dest.resize(offset + blocksX * blocksY * blockSize);
+
+            Array<Palette::Color, 16> block;
+
+            for (uint by = 0; by < blocksY; by++) {
+                for (uint bx = 0; bx < blocksX; bx++) {
+                    for (uint i = 0; i < 16; i++)
+                        block[i] = image.Get(bx * 4 + i % 4, by * 4 + i / 4);
+
+                    auto out = &dest[offset + (by * blocksX + bx) * blockSize];
+                    if (hasAlpha) {
+                        EncodeAlphaBlock(block, out);
+                        out += 8;
+                    }
+
+                    EncodeColorBlock(block, out);
+                }
+            }
+        }
+
+        struct DDSPixelFormat {
+            uint32 Size = 32;
+            uint32 Flags = 0;
+            uint32 FourCC = 0;
+            uint32 RGBBitCount = 0;
+            uint32 RBitMask = 0, GBitMask = 0, BBitMask = 0, ABitMask = 0;
+        };
+
+        struct DDSHeader {
+            uint32 Size = 124;
+            uint32 Flags = 0;
+            uint32 Height = 0, Width = 0;
+            uint32 PitchOrLinearSize = 0;
+            uint32 Depth = 0;
+            uint32 MipMapCount = 0;
+            uint32 Reserved1[11]{};
+            DDSPixelFormat PixelFormat;
+            uint32 Caps = 0, Caps2 = 0, Caps3 = 0, Caps4 = 0;
+            uint32 Reserved2 = 0;
+        };
+
+        static_assert(sizeof(DDSHeader) == 124);
+
+        constexpr uint32 DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8;
+        constexpr uint32 DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+        constexpr uint32 DDPF_ALPHAPIXELS = 0x1, DDPF_FOURCC = 0x4, DDPF_RGB = 0x40;
+        constexpr uint32 DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+
+        void WriteDDSHeader(List<ubyte>& dds, uint width, uint height, uint mips, bool compressed, bool hasAlpha) {
+            DDSHeader header;
+            header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+            header.Width = width;
+            header.Height = height;
+            header.MipMapCount = mips;
+            header.Caps = DDSCAPS_TEXTURE | (mips > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+            if (compressed) {
+                header.Flags |= DDSD_LINEARSIZE;
+                header.PitchOrLinearSize = (width / 4) * (height / 4) * (hasAlpha ? 16 : 8);
+                header.PixelFormat.Flags = DDPF_FOURCC;
+                header.PixelFormat.FourCC = hasAlpha ? MakeFourCC("DXT5") : MakeFourCC("DXT1");
+            }
+            else {
+                header.Flags |= DDSD_PITCH;
+                header.PitchOrLinearSize = width * 4;
+                header.PixelFormat.Flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+                header.PixelFormat.RGBBitCount = 32;
+                header.PixelFormat.RBitMask = 0x000000ff;
+                header.PixelFormat.GBitMask = 0x0000ff00;
+                header.PixelFormat.BBitMask = 0x00ff0000;
+                header.PixelFormat.ABitMask = 0xff000000;
+            }
+
+            constexpr uint32 magic = MakeFourCC("DDS ");
+            dds.resize(sizeof magic + sizeof header);
+            memcpy(dds.data(), &magic, sizeof magic);
+            memcpy(dds.data() + sizeof magic, &header, sizeof header);
+        }
+    }
+
+    void ProcessTexture(span<const Palette::Color> pixels, uint width, uint height,
+                        const TextureProcessOptions& options, List<ubyte>& dds) {
+        assert(pixels.size() == width * height);
+        dds.clear();
+
+        Image mip{ width, height, List<Palette::Color>(pixels.begin(), pixels.end()) };
+        auto mips = 1 + (uint)std::floor(std::log2(std::max(width, height)));
+        bool hasAlpha = ranges::any_of(pixels, [](auto& c) { return c.a < 255; });
+        bool compress = options.Compress && width % 4 == 0 && height % 4 == 0;
+
+        WriteDDSHeader(dds, width, height, mips, compress, hasAlpha);
+
+        for (uint i = 0; i < mips; i++) {
+            if (i > 0)
+                mip = Downsample(mip, options.GammaCorrect);
+
+            if (compress) {
+                CompressImage(mip, hasAlpha, dds);
+            }
+            else {
+                auto bytes = span((const ubyte*)mip.Pixels.data(), mip.Pixels.size() * sizeof(Palette::Color));
+                dds.insert(dds.end(), bytes.begin(), bytes.end());
+            }
+        }
+    }
+
+    void ProcessTextureCached(span<const Palette::Color> pixels, uint width, uint height,
+                              const TextureProcessOptions& options, List<ubyte>& dds) {
+        uint32 params[] = { width, height, options.GammaCorrect, options.Compress, PROCESS_VERSION };
+        auto hash = HashBytes(span((const ubyte*)pixels.data(), pixels.size_bytes()));
+        hash = HashBytes(span((const ubyte*)params, sizeof params), hash);
+        auto path = TEXTURE_CACHE_FOLDER / fmt::format("{:016x}.dds", hash);
+
+        try {
+            if (filesystem::exists(path)) {
+                auto size = filesystem::file_size(path);
+                std::ifstream stream(path, std::ios::binary);
+                dds.resize(size);
+                stream.read((char*)dds.data(), size);
+                if (stream && size > sizeof(DDSHeader)) return;
+            }
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to read cached texture `{}`: {}", path.string(), e.what());
+        }
+
+        ProcessTexture(pixels, width, height, options, dds);
+
+        try {
+            // Write to a temporary file first, as other threads could be processing the same texture
+            filesystem::create_directories(TEXTURE_CACHE_FOLDER);
+            auto tempPath = path;
+            tempPath += fmt::format(".{}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+            {
+                std::ofstream stream(tempPath, std::ios::binary);
+                stream.write((char*)dds.data(), dds.size());
+            }
+
+            filesystem::rename(tempPath, path);
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to cache texture `{}`: {}", path.string(), e.what());
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Types.h"
+#include "Pig.h"
+
+// CPU mipmap generation and block compression. Results are written as DDS files in memory.
+namespace Inferno::Render {
+    struct TextureProcessOptions {
+        // Filters mips in linear space instead of sRGB. Use for color data, not masks.
+        bool GammaCorrect = true;
+        // Block compresses the texture. BC1 when opaque, BC3 when it has alpha.
+        // Ignored when the dimensions are not a multiple of 4.
+        bool Compress = true;
+    };
+
+    // Generates a full mip chain from premultiplied RGBA pixels and writes it to dds.
+    // Transparent and supertransparent pixels have no color, so they don't bleed into lower mips.
+    void ProcessTexture(span<const Palette::Color> pixels, uint width, uint height,
+                        const TextureProcessOptions& options, List<ubyte>& dds);
+
+    // Same as ProcessTexture, but reuses results cached on disk by a hash of the pixels and options
+    void ProcessTextureCached(span<const Palette::Color> pixels, uint width, uint height,
+                              const TextureProcessOptions& options, List<ubyte>& dds);
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "LevelTextureIndex.h"
+#include "Resources.h"
+
+namespace Inferno {
+    void LevelTextureIndex::Invalidate(const Set<Tag>& sides) {
+        std::scoped_lock lock(_lock);
+        Seq::insert(_dirty, sides);
+    }
+
+    void LevelTextureIndex::Invalidate(const Set<SegID>& segments) {
+        std::scoped_lock lock(_lock);
+        for (auto& segId : segments)
+            for (auto& sideId : SideIDs)
+                _dirty.insert({ segId, sideId });
+    }
+
+    void LevelTextureIndex::InvalidateAll() {
+        std::scoped_lock lock(_lock);
+        _rescan = true;
+    }
+
+    void LevelTextureIndex::Sync(const Level& level) {
+        std::scoped_lock lock(_lock);
+        auto sideCount = level.Segments.size() * 6;
+
+        // Removing segments renumbers the ones after them
+        if (sideCount < _sides.size()) {
+            for (size_t i = sideCount; i < _sides.size(); i++)
+                Remove({ SegID(i / 6), SideID(i % 6) }, _sides[i]);
+
+            _rescan = true;
+        }
+
+        auto prevCount = _sides.size();
+        _sides.resize(sideCount);
+
+        if (_rescan) {
+            for (int segId = 0; segId < level.Segments.size(); segId++)
+                for (auto& sideId : SideIDs)
+                    UpdateSide(level, { (SegID)segId, sideId });
+        }
+        else {
+            // Added segments
+            for (size_t i = prevCount; i < sideCount; i++)
+                UpdateSide(level, { SegID(i / 6), SideID(i % 6) });
+
+            for (auto& tag : _dirty) {
+                if (level.SegmentExists(tag.Segment))
+                    UpdateSide(level, tag);
+            }
+        }
+
+        _dirty.clear();
+        _rescan = false;
+    }
+
+    void LevelTextureIndex::UpdateSide(const Level& level, Tag tag) {
+        auto& seg = level.Segments[(int)tag.Segment];
+        auto& side = seg.GetSide(tag.Side);
+        SideState state;
+
+        if (!seg.SideHasConnection(tag.Side) || seg.SideIsWall(tag.Side))
+            state.TMap = side.TMap;
+
+        if (side.HasOverlay())
+            state.TMap2 = side.TMap2;
+
+        if (auto wall = level.TryGetWall(side.Wall))
+            state.Clip = wall->Clip;
+
+        auto& prev = _sides[(int)tag.Segment * 6 + (int)tag.Side];
+        if (prev == state) return;
+
+        Remove(tag, prev);
+        Add(tag, state);
+        prev = state;
+    }
+
+    void LevelTextureIndex::Clear() {
+        std::scoped_lock lock(_lock);
+        _sides.clear();
+        _baseSides.clear();
+        _overlaySides.clear();
+        _textureRefs.clear();
+        _clipRefs.clear();
+        _resident.clear();
+        _dirty.clear();
+        _rescan = true;
+    }
+
+    Set<Tag> LevelTextureIndex::GetBaseSides(LevelTexID id) const {
+        std::scoped_lock lock(_lock);
+        auto sides = _baseSides.find(id);
+        return sides == _baseSides.end() ? Set<Tag>{} : sides->second;
+    }
+
+    Set<Tag> LevelTextureIndex::GetOverlaySides(LevelTexID id) const {
+        std::scoped_lock lock(_lock);
+        auto sides = _overlaySides.find(id);
+        return sides == _overlaySides.end() ? Set<Tag>{} : sides->second;
+    }
+
+    int LevelTextureIndex::GetUseCount(LevelTexID id) const {
+        std::scoped_lock lock(_lock);
+        auto refs = _textureRefs.find(id);
+        return refs == _textureRefs.end() ? 0 : refs->second;
+    }
+
+    void LevelTextureIndex::GetResidentTextures(Set<TexID>& ids) const {
+        std::scoped_lock lock(_lock);
+        for (auto& id : _resident | views::keys)
+            ids.insert(id);
+    }
+
+    void LevelTextureIndex::Add(Tag tag, const SideState& state) {
+        if (state.TMap != LevelTexID::None) {
+            _baseSides[state.TMap].insert(tag);
+            AddTexture(state.TMap, 1);
+        }
+
+        if (state.TMap2 != LevelTexID::None) {
+            _overlaySides[state.TMap2].insert(tag);
+            AddTexture(state.TMap2, 1);
+        }
+
+        if (state.Clip != WClipID::None)
+            AddClip(state.Clip, 1);
+    }
+
+    void LevelTextureIndex::Remove(Tag tag, const SideState& state) {
+        auto erase = [tag](Dictionary<LevelTexID, Set<Tag>>& index, LevelTexID id) {
+            auto sides = index.find(id);
+            if (sides == index.end()) return;
+            sides->second.erase(tag);
+            if (sides->second.empty()) index.erase(sides);
+        };
+
+        if (state.TMap != LevelTexID::None) {
+            erase(_baseSides, state.TMap);
+            AddTexture(state.TMap, -1);
+        }
+
+        if (state.TMap2 != LevelTexID::None) {
+            erase(_overlaySides, state.TMap2);
+            AddTexture(state.TMap2, -1);
+        }
+
+        if (state.Clip != WClipID::None)
+            AddClip(state.Clip, -1);
+    }
+
+    // Updates the reference count of a level texture.
+    // The resident textures only change when the first use is added or the last use is removed.
+    void LevelTextureIndex::AddTexture(LevelTexID id, int refs) {
+        auto& count = _textureRefs[id];
+        bool wasUsed = count > 0;
+        count += refs;
+        bool isUsed = count > 0;
+        if (!isUsed) _textureRefs.erase(id);
+        if (wasUsed == isUsed) return;
+
+        auto texId = Resources::LookupLevelTexID(id);
+        AddResident(span(&texId, 1), isUsed ? 1 : -1);
+        AddResident(Resources::GetEffectClip(id).VClip.GetFrames(), isUsed ? 1 : -1);
+    }
+
+    void LevelTextureIndex::AddClip(WClipID id, int refs) {
+        auto& count = _clipRefs[id];
+        bool wasUsed = count > 0;
+        count += refs;
+        bool isUsed = count > 0;
+        if (!isUsed) _clipRefs.erase(id);
+        if (wasUsed == isUsed) return;
+
+        if (auto wclip = Resources::TryGetWallClip(id)) {
+            auto frames = Seq::map(wclip->GetFrames(), Resources::LookupLevelTexID);
+            AddResident(frames, isUsed ? 1 : -1);
+        }
+    }
+
+    void LevelTextureIndex::AddResident(span<const TexID> ids, int refs) {
+        for (auto& id : ids) {
+            auto& count = _resident[id];
+            count += refs;
+            if (count <= 0) _resident.erase(id);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <mutex>
+#include "Level.h"
+
+namespace Inferno {
+    // Tracks which sides use each level texture and which textures need to be resident for the level geometry.
+    // Edits invalidate the sides they touch and Sync() only updates those sides,
+    // so the cost is proportional to the edit instead of the level.
+    class LevelTextureIndex {
+        // What a side contributes to the index
+        struct SideState {
+            LevelTexID TMap = LevelTexID::None; // None when the side isn't visible
+            LevelTexID TMap2 = LevelTexID::None; // None when there is no overlay
+            WClipID Clip = WClipID::None;
+
+            bool operator==(const SideState&) const = default;
+        };
+
+        List<SideState> _sides; // Six per segment
+        Dictionary<LevelTexID, Set<Tag>> _baseSides, _overlaySides;
+        Dictionary<LevelTexID, int> _textureRefs; // Uses of each level texture as a base or overlay
+        Dictionary<WClipID, int> _clipRefs; // Uses of each door clip
+        Dictionary<TexID, int> _resident; // Number of used level textures and clips that need each TexID
+        Set<Tag> _dirty; // Sides to update on the next sync
+        bool _rescan = true; // Update every side on the next sync
+        mutable std::mutex _lock;
+
+    public:
+        // Marks sides to update on the next sync
+        void Invalidate(const Set<Tag>& sides);
+
+        // Marks every side of the segments to update on the next sync
+        void Invalidate(const Set<SegID>& segments);
+
+        // Rescans the whole level on the next sync. Use for changes without a region, such as undo.
+        void InvalidateAll();
+
+        // Updates the invalidated sides. New segments are added and the level is rescanned if segments were removed.
+        void Sync(const Level& level);
+
+        // Discards the index. Call when the game data changes, as level textures can resolve to different TexIDs.
+        void Clear();
+
+        // Visible sides that use a texture as the base
+        Set<Tag> GetBaseSides(LevelTexID id) const;
+
+        // Sides that use a texture as an overlay, including sides that aren't visible
+        Set<Tag> GetOverlaySides(LevelTexID id) const;
+
+        // Number of times a level texture is used as a base or overlay
+        int GetUseCount(LevelTexID id) const;
+
+        // Adds the textures used by level geometry, including effect and door frames
+        void GetResidentTextures(Set<TexID>& ids) const;
+
+    private:
+        void UpdateSide(const Level& level, Tag tag);
+        void Add(Tag tag, const SideState& state);
+        void Remove(Tag tag, const SideState& state);
+        void AddTexture(LevelTexID id, int refs);
+        void AddClip(WClipID id, int refs);
+        void AddResident(span<const TexID> ids, int refs);
+    };
+}
\ No newline at end of file
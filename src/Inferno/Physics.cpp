@@ -11,6 +11,7 @@
 #include "Editor/Events.h"
 #include "Graphics/Render.Particles.h"
 #include "Game.Wall.h"
+#include "TrianglePacket.h"
 
 using namespace DirectX;
 
@@ -683,17 +684,16 @@ namespace Inferno {
 
         while (segId > SegID::None) {
             auto& seg = level.GetSegment(segId);
+            auto sideHits = IntersectSides(level, seg, ray);
 
             for (auto& side : SideIDs) {
-                auto face = Face::FromSide(level, seg, side);
-
-                float dist{};
-                if (face.Intersects(ray, dist) && dist < hit.Distance) {
-                    if (dist > maxDist) return {}; // hit is too far
+                auto& dist = sideHits[(int)side];
+                if (dist && *dist < hit.Distance) {
+                    if (*dist > maxDist) return {}; // hit is too far
 
                     if (seg.SideIsSolid(side, level)) { // todo: this isn't accurate due to door flags
                         hit.Tag = { segId, side };
-                        hit.Distance = dist;
+                        hit.Distance = *dist;
                         hit.Normal = {}; // todo: normal
                         return true;
                     }
@@ -979,6 +979,7 @@ namespace Inferno {
                                 Sound::Sound3D sound(hit.Point, hit.Tag.Segment);
                                 sound.Resource = Resources::GetSoundResource(Sound::SOUND_WEAPON_HIT_DOOR);
                                 sound.Source = obj.Parent;
+                                sound.Priority = Sound::PRIORITY_CUE;
                                 Sound::Play(sound);
                             }
                             else if (wall->State != WallState::DoorOpening) {
@@ -3,8 +3,11 @@
 #include "FileSystem.h"
 #include "Sound.h"
 #include "Pig.h"
+#include "GameDataCache.h"
 #include <fstream>
 #include <mutex>
+#include <future>
+#include <chrono>
 #include "Game.h"
 #include "logging.h"
 #include "Graphics/Render.h"
@@ -24,6 +27,19 @@ namespace Inferno::Resources {
 
         std::mutex PigMutex;
         List<PaletteInfo> AvailablePalettes;
+
+        struct OutrageVClipInfo {
+            string FileName;
+            float Speed = 1;
+            std::shared_future<Outrage::VClip> Frames; // Valid after the first request
+        };
+
+        List<OutrageVClipInfo> OutrageVClips;
+        bool OutrageVClipsListed = false; // All animated textures have been added
+        std::mutex OutrageVClipMutex;
+
+        Dictionary<string, OutrageModelID> OutrageModelLookup; // Lowercase name to id
+        List<Ptr<Outrage::Model>> OutrageModels; // Null when the model couldn't be read
     }
 
     int GetTextureCount() { return (int)Textures.size(); }
@@ -79,12 +95,8 @@ namespace Inferno::Resources {
     }
 
     WClipID GetWallClipID(LevelTexID id) {
-        for (int i = 0; i < GameData.WallClips.size(); i++) {
-            if (GameData.WallClips[i].Frames[0] == id)
-                return WClipID(i);
-        }
-
-        return WClipID::None;
+        if (!Seq::inRange(GameData.WallClipLookup, (int)id)) return WClipID::None;
+        return GameData.WallClipLookup[(int)id];
     }
 
     EffectClip DEFAULT_EFFECT_CLIP = {};
@@ -95,12 +107,9 @@ namespace Inferno::Resources {
     }
 
     const EffectClip& GetEffectClip(TexID id) {
-        for (auto& clip : GameData.Effects) {
-            if (clip.VClip.Frames[0] == id)
-                return clip;
-        }
-
-        return DEFAULT_EFFECT_CLIP;
+        auto eclip = GetEffectClipID(id);
+        if (eclip == EClipID::None) return DEFAULT_EFFECT_CLIP;
+        return GameData.Effects[(int)eclip];
     }
 
     const EffectClip& GetEffectClip(LevelTexID id) {
@@ -109,14 +118,8 @@ namespace Inferno::Resources {
     }
 
     EClipID GetEffectClipID(TexID tid) {
-        if (tid == TexID::None) return EClipID::None;
-
-        for (int i = 0; i < GameData.Effects.size(); i++) {
-            if (GameData.Effects[i].VClip.Frames[0] == tid)
-                return EClipID(i);
-        }
-
-        return EClipID::None;
+        if (!Seq::inRange(GameData.EffectClipLookup, (int)tid)) return EClipID::None;
+        return GameData.EffectClipLookup[(int)tid];
     }
 
     EClipID GetEffectClipID(LevelTexID id) {
@@ -242,21 +245,34 @@ namespace Inferno::Resources {
         return src.substr(0, offset) + ext;
     }
 
+    // Resolves the average color of the base textures. Stored in the game data cache.
+    void UpdateAverageColors(PigFile& pig, span<const PigBitmap> textures) {
+        for (size_t i = 0; i < pig.Entries.size() && i < textures.size(); i++)
+            pig.Entries[i].AverageColor = GetAverageColor(textures[i].Data);
+    }
+
+    // Updates the average color of textures replaced by a POG or DTX
     void UpdateAverageTextureColor() {
         SPDLOG_INFO("Update average texture color");
 
         for (auto& entry : Pig.Entries) {
-            auto& bmp = GetBitmap(entry.ID);
-            entry.AverageColor = GetAverageColor(bmp.Data);
+            if (auto bmp = CustomTextures.Get(entry.ID))
+                entry.AverageColor = GetAverageColor(bmp->Data);
         }
-        //for (auto& tid : GameData.LevelTexIdx) {
-        //    auto id = LookupLevelTexID(tid);
-        //    if (!Seq::inRange(Pig.Entries, (int)id)) continue;
+    }
+
+    // Game data caches are written relative to the working directory
+    const filesystem::path GAME_DATA_CACHE_FOLDER = "cache";
 
-        //    auto& entry = Pig.Entries[(int)id];
-        //    auto& bmp = ReadBitmap(id);
-        //    entry.AverageColor = GetAverageColor(bmp.Data);
-        //}
+    void TryWriteGameDataCache(const filesystem::path& path, span<const CacheSource> sources,
+                               const HamFile& ham, const PigFile& pig, const Palette& palette) {
+        try {
+            WriteGameDataCache(path, sources, ham, pig, palette);
+            SPDLOG_INFO(L"Wrote game data cache `{}`", path.wstring());
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to write game data cache: {}", e.what());
+        }
     }
 
     // Reads a file from the current mission or the file system
@@ -310,9 +326,6 @@ namespace Inferno::Resources {
     void LoadDescent2Resources(Level& level) {
         std::scoped_lock lock(PigMutex);
         SPDLOG_INFO("Loading Descent 2 level: '{}'\r\n Version: {} Segments: {} Vertices: {}", level.Name, level.Version, level.Segments.size(), level.Vertices.size());
-        auto hamData = ReadGameResource("descent2.ham");
-        StreamReader reader(hamData);
-        auto ham = ReadHam(reader);
         auto hog = HogFile::Read(FileSystem::FindFile(L"descent2.hog"));
 
         // Find the 256 for the palette first. In most cases it is located inside of the hog.
@@ -320,11 +333,13 @@ namespace Inferno::Resources {
         auto paletteData = hog.TryReadEntry(level.Palette);
         auto pigName = ReplaceExtension(level.Palette, ".pig");
         auto pigPath = FileSystem::FindFile(pigName);
+        Option<filesystem::path> palettePath;
 
         if (paletteData.empty()) {
             // Wasn't in hog, find on filesystem
             if (auto path256 = FileSystem::TryFindFile(level.Palette)) {
                 paletteData = File::ReadAllBytes(*path256);
+                palettePath = path256;
                 pigPath = path256->replace_extension(".pig");
             }
             else {
@@ -333,15 +348,49 @@ namespace Inferno::Resources {
             }
         }
 
-        auto pig = ReadPigFile(pigPath);
-        auto palette = ReadPalette(paletteData);
+        // The cache is only valid when the ham comes from the filesystem and not a mission
+        List<CacheSource> cacheSources;
+        auto hamPath = FileSystem::TryFindFile("descent2.ham");
+        bool useCache = hamPath && !(Game::Mission && Game::Mission->Exists("descent2.ham"));
+        auto cachePath = GAME_DATA_CACHE_FOLDER / fmt::format("d2-{}{}.gdc", String::ToLower(pigPath.stem().string()), level.IsVertigo() ? "-x" : "");
+
+        if (useCache) {
+            cacheSources = { GetCacheSource(hog.Path), GetCacheSource(*hamPath), GetCacheSource(pigPath) };
+            if (palettePath) cacheSources.push_back(GetCacheSource(*palettePath));
+            if (level.IsVertigo()) cacheSources.push_back(GetCacheSource(FileSystem::FindFile(L"d2x.hog")));
+        }
+
+        HamFile ham;
+        PigFile pig;
+        Palette palette;
+        auto cache = useCache ? ReadGameDataCache(cachePath, cacheSources) : Option<GameDataCache>();
+
+        if (cache) {
+            SPDLOG_INFO(L"Loaded game data cache `{}`", cachePath.wstring());
+            ham = std::move(cache->Ham);
+            pig = std::move(cache->Pig);
+            palette = std::move(cache->Palette);
+        }
+        else {
+            auto hamData = ReadGameResource("descent2.ham");
+            StreamReader reader(hamData);
+            ham = ReadHam(reader);
+            pig = ReadPigFile(pigPath);
+            palette = ReadPalette(paletteData);
+
+            if (level.IsVertigo()) {
+                auto vHog = HogFile::Read(FileSystem::FindFile(L"d2x.hog"));
+                auto data = vHog.ReadEntry("d2x.ham");
+                StreamReader vReader(data);
+                AppendVHam(vReader, ham);
+            }
+        }
+
         auto textures = ReadAllBitmaps(pig, palette);
 
-        if (level.IsVertigo()) {
-            auto vHog = HogFile::Read(FileSystem::FindFile(L"d2x.hog"));
-            auto data = vHog.ReadEntry("d2x.ham");
-            StreamReader vReader(data);
-            AppendVHam(vReader, ham);
+        if (!cache) {
+            UpdateAverageColors(pig, textures);
+            if (useCache) TryWriteGameDataCache(cachePath, cacheSources, ham, pig, palette);
         }
 
         filesystem::path folder = level.Path;
@@ -451,17 +500,41 @@ namespace Inferno::Resources {
         std::scoped_lock lock(PigMutex);
         SPDLOG_INFO("Loading Descent 1 level: '{}'\r\n Version: {} Segments: {} Vertices: {}", level.Name, level.Version, level.Segments.size(), level.Vertices.size());
         auto hog = HogFile::Read(FileSystem::FindFile(L"descent.hog"));
-        auto paletteData = hog.ReadEntry("palette.256");
-        auto palette = ReadPalette(paletteData);
-
         auto path = FileSystem::FindFile(L"descent.pig");
-        StreamReader reader(path);
-        auto [ham, pig, sounds] = ReadDescent1GameData(reader, palette);
-        pig.Path = path;
-        sounds.Path = path;
+
+        List<CacheSource> cacheSources = { GetCacheSource(hog.Path), GetCacheSource(path) };
+        auto cachePath = GAME_DATA_CACHE_FOLDER / "d1.gdc";
+
+        HamFile ham;
+        PigFile pig;
+        Palette palette;
+        auto cache = ReadGameDataCache(cachePath, cacheSources);
+
+        if (cache) {
+            SPDLOG_INFO(L"Loaded game data cache `{}`", cachePath.wstring());
+            ham = std::move(cache->Ham);
+            pig = std::move(cache->Pig);
+            palette = std::move(cache->Palette);
+        }
+        else {
+            auto paletteData = hog.ReadEntry("palette.256");
+            palette = ReadPalette(paletteData);
+
+            StreamReader reader(path);
+            auto [d1Ham, d1Pig, sounds] = ReadDescent1GameData(reader, palette);
+            ham = std::move(d1Ham);
+            pig = std::move(d1Pig);
+            pig.Path = path;
+        }
+
         //ReadBitmap(pig, palette, TexID(61)); // cockpit
         auto textures = ReadAllBitmaps(pig, palette);
 
+        if (!cache) {
+            UpdateAverageColors(pig, textures);
+            TryWriteGameDataCache(cachePath, cacheSources, ham, pig, palette);
+        }
+
         filesystem::path folder = level.Path;
         folder.remove_filename();
         auto dtx = ReplaceExtension(level.FileName, ".dtx");
@@ -525,6 +598,7 @@ namespace Inferno::Resources {
     void LoadLevel(Level& level) {
         try {
             ResetResources();
+            Game::LevelTextures.Clear(); // Level textures can map to different TexIDs after loading
 
             if (level.IsDescent2()) {
                 LoadDescent2Resources(level);
@@ -608,29 +682,199 @@ namespace Inferno::Resources {
         return {};
     }
 
-    void LoadVClips() {
-        for (auto& tex : GameTable.Textures) {
-            if (!tex.Animated()) continue;
+    // Reads a file from the data paths or the D3 hog
+    Option<List<ubyte>> ReadOutrageFile(const string& name) {
+        if (auto path = FileSystem::TryFindFile(name))
+            return File::ReadAllBytes(*path);
+
+        return Descent3Hog.ReadEntry(name);
+    }
+
+    // Returns where an Outrage file is read from. Hog entries use the modified time of the hog and their own timestamp.
+    Option<CacheSource> GetOutrageSource(const string& name) {
+        if (auto path = FileSystem::TryFindFile(name))
+            return GetCacheSource(*path);
+
+        auto index = Descent3Hog.Find(name);
+        if (index == -1) return {};
+
+        auto& entry = Descent3Hog.Entries[index];
+        auto source = GetCacheSource(Descent3Hog.Path);
+        source.Path = fmt::format("{}/{}/{}", source.Path, entry.name, entry.timestamp);
+        source.Size = entry.len;
+        return source;
+    }
+
+    // Decoded files are named by a hash of their source path, size and modified time,
+    // so the source only needs to be read when it changed or was never decoded
+    filesystem::path GetOutrageCachePath(const CacheSource& source, string_view extension) {
+        auto key = fmt::format("{}|{}|{}", source.Path, source.Size, source.WriteTime);
+        auto hash = HashBytes({ (const ubyte*)key.data(), key.size() });
+        return GAME_DATA_CACHE_FOLDER / "d3" / fmt::format("{:016x}.{}", hash, extension);
+    }
+
+    void TryWriteOutrageCache(const filesystem::path& path, auto&& write) {
+        try {
+            // Write to a temporary file first, as other threads could be decoding the same file
+            auto tempPath = path;
+            tempPath += fmt::format(".{}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+            write(tempPath);
+            filesystem::rename(tempPath, path);
+        }
+        catch (const std::exception& e) {
+            SPDLOG_WARN("Unable to write bitmap cache `{}`: {}", path.string(), e.what());
+        }
+    }
+
+    Outrage::VClip ReadOutrageVClip(const string& fileName, float speed) {
+        Outrage::VClip vc;
+
+        try {
+            if (auto source = GetOutrageSource(fileName)) {
+                auto cachePath = GetOutrageCachePath(*source, "oafc");
+
+                if (auto cached = ReadOutrageVClipCache(cachePath)) {
+                    vc = std::move(*cached);
+                }
+                else if (auto data = ReadOutrageFile(fileName)) {
+                    StreamReader reader(std::move(*data), fileName);
+                    vc = Outrage::VClip::Read(reader);
+                    TryWriteOutrageCache(cachePath, [&vc](auto& path) { WriteOutrageVClipCache(path, vc); });
+                }
+            }
+            else {
+                SPDLOG_WARN("VClip not found: {}", fileName);
+            }
+        }
+        catch (const std::exception& e) {
+            SPDLOG_ERROR("Error reading VClip {}: {}", fileName, e.what());
+            vc = {};
+        }
+
+        // Frame time comes from the game table
+        if (vc.Frames.size() > 0)
+            vc.FrameTime = speed / vc.Frames.size();
+
+        vc.FileName = fileName;
+        return vc;
+    }
+
+    // Adds an animated texture to the vclip list. Returns the existing id if already added.
+    // Frames are decoded when the vclip is first requested.
+    int AddOutrageVClip(const Outrage::TextureInfo& tex) {
+        for (int id = 0; id < OutrageVClips.size(); id++) {
+            if (OutrageVClips[id].FileName == tex.FileName)
+                return id;
+        }
+
+        OutrageVClips.push_back({ tex.FileName, tex.Speed });
+        return (int)OutrageVClips.size() - 1;
+    }
 
-            if (auto r = OpenFile(tex.FileName)) {
-                auto vc = Outrage::VClip::Read(*r);
-                if (vc.Frames.size() > 0)
-                    vc.FrameTime = tex.Speed / vc.Frames.size();
-                vc.FileName = tex.FileName;
-                VClips.push_back(std::move(vc));
+    int GetOutrageVClipCount() {
+        std::scoped_lock lock(OutrageVClipMutex);
+
+        if (!OutrageVClipsListed) {
+            // Every texture page has to be decoded to know which ones are animated
+            for (int i = 0; i < GameTable.GetTexturePages().size(); i++) {
+                auto& tex = GameTable.GetTexture(i);
+                if (tex.Animated())
+                    AddOutrageVClip(tex);
             }
+
+            OutrageVClipsListed = true;
+        }
+
+        return (int)OutrageVClips.size();
+    }
+
+    int FindOutrageVClip(const string& fileName) {
+        std::scoped_lock lock(OutrageVClipMutex);
+        for (int id = 0; id < OutrageVClips.size(); id++) {
+            if (String::InvariantEquals(OutrageVClips[id].FileName, fileName))
+                return id;
+        }
+
+        if (auto tex = GameTable.FindTextureByFileName(fileName); tex && tex->Animated())
+            return AddOutrageVClip(*tex);
+
+        // Animations that aren't in the game table use the default speed
+        if (String::InvariantEquals(String::Extension(fileName), "oaf") && GetOutrageSource(fileName)) {
+            OutrageVClips.push_back({ fileName });
+            return (int)OutrageVClips.size() - 1;
         }
+
+        return -1;
+    }
+
+    int FindDecodedOutrageVClip(const string& frameName) {
+        std::scoped_lock lock(OutrageVClipMutex);
+
+        for (int id = 0; id < OutrageVClips.size(); id++) {
+            auto& frames = OutrageVClips[id].Frames;
+            if (!frames.valid() || frames.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
+
+            for (auto& frame : frames.get().Frames) {
+                if (String::InvariantEquals(frame.Name, frameName))
+                    return id;
+            }
+        }
+
+        return -1;
+    }
+
+    void RequestOutrageVClip(int id) {
+        std::scoped_lock lock(OutrageVClipMutex);
+        if (!Seq::inRange(OutrageVClips, id)) return;
+
+        auto& info = OutrageVClips[id];
+        if (!info.Frames.valid())
+            info.Frames = std::async(std::launch::async, ReadOutrageVClip, info.FileName, info.Speed).share();
+    }
+
+    const Outrage::VClip& GetOutrageVClip(int id) {
+        static const Outrage::VClip empty;
+        RequestOutrageVClip(id);
+
+        std::shared_future<Outrage::VClip> frames;
+
+        {
+            std::scoped_lock lock(OutrageVClipMutex);
+            if (!Seq::inRange(OutrageVClips, id)) return empty;
+            frames = OutrageVClips[id].Frames;
+        }
+
+        // The list keeps the result alive until D3 is mounted again
+        return frames.get();
     }
 
     void MountDescent3() {
         try {
             if (auto path = FileSystem::TryFindFile("d3.hog")) {
                 SPDLOG_INFO(L"Loading {} and Table.gam", path->wstring());
+
+                auto start = std::chrono::steady_clock::now();
+
+                {
+                    // Wait for pending vclips before replacing the hog they read from
+                    std::scoped_lock lock(OutrageVClipMutex);
+                    OutrageVClips.clear();
+                    OutrageVClipsListed = false;
+                }
+
+                OutrageModels.clear();
+                OutrageModelLookup.clear();
                 Descent3Hog = Hog2::Read(*path);
-                if (auto r = OpenFile("Table.gam"))
-                    GameTable = Outrage::GameTable::Read(*r);
 
-                LoadVClips();
+                // Only the page names are read here. Pages are decoded when they are looked up.
+                if (auto data = ReadOutrageFile("Table.gam"))
+                    GameTable = Outrage::GameTable::Read(std::move(*data));
+
+                std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                SPDLOG_INFO("Mounted Descent 3 in {:.2f} ms. Indexed {} textures, {} sounds and {} generics",
+                            elapsed.count(), GameTable.GetTexturePages().size(),
+                            GameTable.GetSoundPages().size(), GameTable.GetGenericPages().size());
             }
 
             //if (auto path = FileSystem::TryFindFile("merc.hog")) {
@@ -643,10 +887,20 @@ namespace Inferno::Resources {
     }
 
     Option<Outrage::Bitmap> ReadOutrageBitmap(const string& name) {
-        if (auto r = OpenFile(name))
-            return Outrage::Bitmap::Read(*r);
+        auto source = GetOutrageSource(name);
+        if (!source) return {};
 
-        return {};
+        auto cachePath = GetOutrageCachePath(*source, "ogfc");
+        if (auto bitmap = ReadOutrageBitmapCache(cachePath))
+            return bitmap;
+
+        auto data = ReadOutrageFile(name);
+        if (!data) return {};
+
+        StreamReader reader(std::move(*data), name);
+        auto bitmap = Outrage::Bitmap::Read(reader);
+        TryWriteOutrageCache(cachePath, [&bitmap](auto& path) { WriteOutrageBitmapCache(path, bitmap); });
+        return bitmap;
     }
 
     Option<Outrage::Model> ReadOutrageModel(const string& name) {
@@ -656,20 +910,29 @@ namespace Inferno::Resources {
         return {};
     }
 
-    Dictionary<string, Outrage::Model> OutrageModels;
+    OutrageModelID LoadOutrageModel(const string& name) {
+        auto key = String::ToLower(name);
+        if (auto id = OutrageModelLookup.find(key); id != OutrageModelLookup.end())
+            return id->second;
 
-    Outrage::Model const* GetOutrageModel(const string& name) {
-        if (OutrageModels.contains(name))
-            return &OutrageModels[name];
+        auto id = (OutrageModelID)OutrageModels.size();
+        auto& resident = OutrageModels.emplace_back();
+        OutrageModelLookup[key] = id;
 
         if (auto model = ReadOutrageModel(name)) {
-            for (auto& texture : model->Textures) {
-                model->TextureHandles.push_back(Render::NewTextureCache->ResolveFileName(texture));
-            }
-            OutrageModels[name] = std::move(*model);
-            return &OutrageModels[name];
+            model->TextureHandles = Render::NewTextureCache->ResolveFileNames(model->Textures);
+            resident = MakePtr<Outrage::Model>(std::move(*model));
         }
 
-        return nullptr;
+        return id;
+    }
+
+    Outrage::Model const* GetOutrageModel(OutrageModelID id) {
+        if (!Seq::inRange(OutrageModels, (int)id)) return nullptr;
+        return OutrageModels[(int)id].get();
+    }
+
+    Outrage::Model const* GetOutrageModel(const string& name) {
+        return GetOutrageModel(LoadOutrageModel(name));
     }
 };
@@ -79,15 +79,31 @@ namespace Inferno::Resources {
 
     inline Hog2 Descent3Hog, Mercenary;
     inline Outrage::GameTable GameTable;
-    inline List<Outrage::VClip> VClips; // Expanded from OAF headers
 
     void MountDescent3();
 
     Option<StreamReader> OpenFile(const string& name);
 
+    // Descent 3 animated textures from the game table. Frames are decoded in the background on first use.
+    int GetOutrageVClipCount();
+    int FindOutrageVClip(const string& fileName); // Returns -1 if not found. Does not decode the frames.
+    int FindDecodedOutrageVClip(const string& frameName); // Searches vclips that finished decoding for a frame. Returns -1 if not found.
+    void RequestOutrageVClip(int id); // Starts decoding the frames if they haven't been already
+    const Outrage::VClip& GetOutrageVClip(int id); // Waits for the frames to finish decoding
+
+    // Reads a bitmap, reusing the decoded pixels from the disk cache when possible
     Option<Outrage::Bitmap> ReadOutrageBitmap(const string& name);
     Option<Outrage::Model> ReadOutrageModel(const string& name);
 
+    // Interned name of a D3 model. Valid until Descent 3 is mounted again.
+    enum class OutrageModelID { None = -1 };
+
+    // Returns the id of a model, reading it and resolving its textures on first use.
+    // The model stays resident, so later calls don't touch the disk even if the model is missing.
+    OutrageModelID LoadOutrageModel(const string& name);
+
+    // Returns null if the model couldn't be read
+    Outrage::Model const* GetOutrageModel(OutrageModelID id);
     Outrage::Model const* GetOutrageModel(const string& name);
 
     // Loads D1 and D2 sounds
@@ -28,9 +28,11 @@ namespace Inferno {
         node |= ryml::MAP;
         node["HighRes"] << s.HighRes;
         node["EnableBloom"] << s.EnableBloom;
+        node["CompressTextures"] << s.CompressTextures;
         node["MsaaSamples"] << s.MsaaSamples;
         node["ForegroundFpsLimit"] << s.ForegroundFpsLimit;
         node["BackgroundFpsLimit"] << s.BackgroundFpsLimit;
+        node["TextureBudget"] << s.TextureBudget;
     }
 
     GraphicsSettings LoadGraphicsSettings(ryml::NodeRef node) {
@@ -38,12 +40,15 @@ namespace Inferno {
         if (node.is_seed()) return s;
         ReadValue(node["HighRes"], s.HighRes);
         ReadValue(node["EnableBloom"], s.EnableBloom);
+        ReadValue(node["CompressTextures"], s.CompressTextures);
         ReadValue(node["MsaaSamples"], s.MsaaSamples);
         if (s.MsaaSamples != 1 && s.MsaaSamples != 2 && s.MsaaSamples != 4 && s.MsaaSamples != 8)
             s.MsaaSamples = 1;
 
         ReadValue(node["ForegroundFpsLimit"], s.ForegroundFpsLimit);
         ReadValue(node["BackgroundFpsLimit"], s.BackgroundFpsLimit);
+        ReadValue(node["TextureBudget"], s.TextureBudget);
+        s.TextureBudget = std::max(s.TextureBudget, 0);
         return s;
     }
 
@@ -133,8 +133,10 @@ namespace Inferno {
     struct GraphicsSettings {
         bool HighRes = false; // Enables high res textures and filtering
         bool EnableBloom = false; // Enables bloom post-processing
+        bool CompressTextures = false; // Generates mipmaps and block compresses textures
         int MsaaSamples = 1;
         int ForegroundFpsLimit = -1, BackgroundFpsLimit = 20;
+        int TextureBudget = 0; // Megabytes of textures to keep loaded before unloading unused ones. 0 is unlimited.
     };
 
     struct InfernoSettings {
@@ -1,5 +1,5 @@
 #include "pch.h"
-#include <list>
+#include <execution>
 #include "DirectX.h"
 #include "SoundSystem.h"
 #include "FileSystem.h"
@@ -8,6 +8,7 @@
 #include "logging.h"
 #include "Graphics/Render.h"
 #include "Physics.h"
+#include "Concurrent.h"
 //#include "DirectXTK12/Audio/WAVFileReader.h"
 #include <vendor/WAVFileReader.h>
 
@@ -22,56 +23,76 @@ namespace Inferno::Sound {
     constexpr float MAX_DISTANCE = 400; // Furthest distance a sound can be heard
     constexpr float MAX_SFX_VOLUME = 0.75; // should come from settings
     constexpr float MERGE_WINDOW = 1 / 10.0f; // Discard the same sound being played by a source within a window
+    constexpr size_t PARALLEL_OCCLUSION_THRESHOLD = 32; // Number of emitters before occlusion rays are cast in parallel
+    constexpr size_t MAX_VOICES = 32; // Maximum number of 3D sounds playing at once
+    constexpr size_t MAX_POOLED_INSTANCES = 4; // Maximum idle instances kept per sound resource
+    constexpr float MAX_PRECACHE_LENGTH = 10; // Sounds longer than this many seconds are converted on first use
+
+    // Estimated loudness of a sound at the listener, from 0 to 1. Position is in audio units.
+    float GetAudibility(const Vector3& position, const Vector3& listener, float volume) {
+        auto dist = (listener - position / AUDIO_SCALE).Length();
+        auto ratio = std::min(dist / MAX_DISTANCE, 1.0f);
+        // 1 / (0.97 + 3x)^2 - 0.065 inverse square that crosses at 0,1 and 1,0
+        //auto volume = 1 / std::powf(0.97 + 3*ratio, 2) - 0.065f;
+        return std::powf(1 - ratio, 3) * volume;
+    }
+
+    // Occlusion and position of an emitter, calculated on the game thread
+    struct EmitterOcclusion {
+        uint32 ID = 0; // ObjectSound ID
+        uint32 Voice = 0; // Index of the voice the sound was playing on
+        Vector3 Position; // Audio position
+        SegID Segment = SegID::None;
+        float Muffle = 1;
+        bool HasSource = false; // The source object still exists
+    };
+
+    // Sound samples converted to the mixer format. Samples point into an arena owned by the cache.
+    struct CachedSound {
+        const int16* Samples = nullptr;
+        size_t Count = 0;
+        uint32 SampleRate = 0;
+    };
 
     struct ObjectSound {
+        uint32 ID = 0; // Unique ID for this instance. Used to match occlusion results
         ObjID Source = ObjID::None;
         size_t Sound = 0; // Unique ID for the source sound. Used for deduplication
         SegID Segment = SegID::None;
         bool Started = false;
         bool AttachToSource = false;
+        bool HasSource = false;
+        float Muffle = 1;
+        float Volume = 1;
+        uint8 Priority = 0;
         Ptr<SoundEffectInstance> Instance;
         AudioEmitter Emitter; // Stores position
         double StartTime = 0;
 
-        void UpdateEmitter(const Vector3& listener, float /*dt*/) {
-            auto obj = Game::Level.TryGetObject(Source);
-            if (obj && AttachToSource) {
-                //Emitter.Update(obj->Position() * AUDIO_SCALE, obj->Transform.Up(), dt);
-                Emitter.SetPosition(obj->Position * AUDIO_SCALE);
-                Segment = obj->Segment;
-            }
+        void ApplyOcclusion(const EmitterOcclusion& occlusion) {
+            if (AttachToSource && occlusion.HasSource)
+                Emitter.SetPosition(occlusion.Position);
 
-            if (obj) {
-                auto emitterPos = Emitter.Position / AUDIO_SCALE;
-                auto delta = listener - emitterPos;
-                Vector3 dir;
-                delta.Normalize(dir);
-                auto dist = delta.Length();
-                auto ratio = std::min(dist / MAX_DISTANCE, 1.0f);
-                // 1 / (0.97 + 3x)^2 - 0.065 inverse square that crosses at 0,1 and 1,0
-                //auto volume = 1 / std::powf(0.97 + 3*ratio, 2) - 0.065f;
-
-                float muffleMult = 1;
-
-                if (dist < MAX_DISTANCE) { // only hit test if sound is actually within range
-                    Ray ray(emitterPos, dir);
-                    LevelHit hit;
-                    if (IntersectLevel(Game::Level, ray, Segment, dist, hit)) {
-                        auto hitDist = (listener - hit.Point).Length();
-                        // we hit a wall, muffle it based on the distance from the source
-                        // a sound coming immediately around the corner shouldn't get muffled much
-                        muffleMult = std::clamp(1 - hitDist / 60, 0.25f, 0.95f);
-                    };
-                }
+            Segment = occlusion.Segment;
+            Muffle = occlusion.Muffle;
+            HasSource = occlusion.HasSource;
+        }
 
-                auto volume = std::powf(1 - ratio, 3);
-                Instance->SetVolume(volume * muffleMult * MAX_SFX_VOLUME);
+        // Estimated loudness at the listener. Used to pick voices to steal.
+        float GetAudibility(const Vector3& listener) const {
+            return Sound::GetAudibility(Emitter.Position, listener, Volume) * Muffle;
+        }
+
+        bool IsPlaying() const { return Instance != nullptr; }
+
+        void UpdateEmitter(const Vector3& listener, float /*dt*/) {
+            if (HasSource) {
+                auto volume = Sound::GetAudibility(Emitter.Position, listener, 1);
+                Instance->SetVolume(volume * Muffle * MAX_SFX_VOLUME);
             }
             else {
                 // object is missing, was likely destroyed. Should the sound stop?
             }
-
-            Debug::Emitters.push_back(Emitter.Position / AUDIO_SCALE);
         }
     };
 
@@ -83,8 +104,35 @@ namespace Inferno::Sound {
 
         std::atomic<bool> Alive = false;
         std::thread WorkerThread;
-        std::list<ObjectSound> ObjectSounds;
-        std::mutex ResetMutex, ObjectSoundsMutex;
+        Array<ObjectSound, MAX_VOICES> Voices;
+        std::mutex ResetMutex, VoiceMutex;
+        uint32 NextSoundID = 1;
+
+        // Idle instances for each sound resource, reused instead of creating new ones
+        Dictionary<size_t, List<Ptr<SoundEffectInstance>>> InstancePool;
+
+        // Converted sound data. Arenas are only released by Reset() so effects can reference them directly.
+        std::mutex CacheMutex;
+        List<Ptr<int16[]>> SoundArenas;
+        Dictionary<size_t, CachedSound> CachedSounds; // Keyed by SoundResource::GetID()
+
+        // Effects and samples released by Reset(). 2D sounds are one-shots that can't be stopped,
+        // so the memory is only freed once none of the effects are playing. Guarded by ResetMutex.
+        struct RetiredSounds {
+            List<Ptr<SoundEffect>> Effects;
+            List<Ptr<int16[]>> Arenas;
+        };
+
+        List<RetiredSounds> Retired;
+        std::atomic<uint32> MixerSampleRate = 0;
+        std::atomic<uint32> CacheGeneration = 0; // Incremented by Reset() so jobs started before it don't publish
+        std::atomic<bool> Precaching = false;
+        std::mutex PrecacheMutex;
+        Option<List<SoundResource>> PendingPrecache; // Latest request, picked up by the running job
+
+        // Occlusion results handed from the game thread to the audio thread
+        TripleBuffer<List<EmitterOcclusion>> Occlusion;
+        List<EmitterOcclusion> OcclusionQueries; // Only accessed by the game thread
 
         AudioListener Listener;
 
@@ -111,6 +159,66 @@ namespace Inferno::Sound {
         };
     }
 
+    // Stops a voice and returns its instance to the pool. VoiceMutex must be held.
+    void ReleaseVoice(ObjectSound& voice) {
+        if (!voice.Instance) return;
+        voice.Instance->Stop();
+
+        auto& pool = InstancePool[voice.Sound];
+        if (pool.size() < MAX_POOLED_INSTANCES)
+            pool.push_back(std::move(voice.Instance));
+
+        voice = {};
+    }
+
+    // Frees retired effects and samples that are no longer playing. ResetMutex must be held.
+    void FreeRetiredSounds() {
+        std::erase_if(Retired, [](const RetiredSounds& retired) {
+            return ranges::none_of(retired.Effects, [](auto& effect) { return effect->IsInUse(); });
+        });
+    }
+
+    // Returns an idle instance for a sound, creating one if none are available. VoiceMutex must be held.
+    Ptr<SoundEffectInstance> AcquireInstance(SoundEffect& sfx, size_t soundId) {
+        auto& pool = InstancePool[soundId];
+        if (!pool.empty()) {
+            auto instance = std::move(pool.back());
+            pool.pop_back();
+            Metrics::ReusedInstances++;
+            return instance;
+        }
+
+        return sfx.CreateInstance(SoundEffectInstance_Use3D | SoundEffectInstance_ReverbUseFilters);
+    }
+
+    // Finds a voice to play a new sound on, stealing the least important voice if all are in use.
+    // Returns null if every playing voice is more important. VoiceMutex must be held.
+    ObjectSound* FindVoice(uint8 priority, float audibility, const Vector3& listener) {
+        ObjectSound* victim = nullptr;
+        float victimAudibility = FLT_MAX;
+
+        for (auto& voice : Voices) {
+            if (!voice.IsPlaying()) return &voice;
+
+            auto voiceAudibility = voice.GetAudibility(listener);
+            if (!victim ||
+                voice.Priority < victim->Priority ||
+                (voice.Priority == victim->Priority && voiceAudibility < victimAudibility)) {
+                victim = &voice;
+                victimAudibility = voiceAudibility;
+            }
+        }
+
+        if (!victim) return nullptr;
+
+        bool moreImportant = priority != victim->Priority ? priority > victim->Priority : audibility > victimAudibility;
+        if (!moreImportant) return nullptr;
+
+        ReleaseVoice(*victim);
+        Metrics::StolenVoices++;
+        return victim;
+    }
+
     void SoundWorker(float volume, milliseconds pollRate) {
         SPDLOG_INFO("Starting audio mixer thread");
 
@@ -132,6 +240,7 @@ namespace Inferno::Sound {
 #endif
             Engine = MakePtr<AudioEngine>(flags, nullptr/*, devices[0].deviceId.c_str()*/);
             Engine->SetDefaultSampleRate(22050); // Change based on D1/D2
+            MixerSampleRate = Engine->GetOutputFormat().Format.nSamplesPerSec;
             SoundsD1.resize(255);
             SoundsD2.resize(255);
             Alive = true;
@@ -144,8 +253,6 @@ namespace Inferno::Sound {
         Engine->SetMasterVolume(volume);
 
         while (Alive) {
-            Debug::Emitters.clear();
-
             if (Engine->Update()) {
                 try {
                     auto dt = pollRate.count() / 1000.0f;
@@ -153,33 +260,52 @@ namespace Inferno::Sound {
                     Listener.SetOrientation(Render::Camera.GetForward(), Render::Camera.Up);
                     Listener.Position = Render::Camera.Position * AUDIO_SCALE;
 
-                    std::scoped_lock lock(ObjectSoundsMutex);
-                    auto sound = ObjectSounds.begin();
-                    while (sound != ObjectSounds.end()) {
-                        auto state = sound->Instance->GetState();
-                        if (state == SoundState::STOPPED && sound->Started) {
+                    Occlusion.Update();
+                    auto& occlusion = Occlusion.Front();
+
+                    std::scoped_lock lock(VoiceMutex);
+
+                    for (auto& result : occlusion) {
+                        auto& voice = Voices[result.Voice];
+                        if (voice.IsPlaying() && voice.ID == result.ID)
+                            voice.ApplyOcclusion(result);
+                    }
+
+                    uint32 activeVoices = 0;
+
+                    for (auto& voice : Voices) {
+                        if (!voice.IsPlaying()) continue;
+
+                        auto state = voice.Instance->GetState();
+                        if (state == SoundState::STOPPED && voice.Started) {
                             // clean up
-                            //SPDLOG_INFO("Removing object sound instance");
-                            ObjectSounds.erase(sound++);
+                            ReleaseVoice(voice);
                             continue;
                         }
 
-                        if (state == SoundState::STOPPED && !sound->Started) {
+                        if (state == SoundState::STOPPED && !voice.Started) {
                             // New sound
-                            sound->Instance->Play();
+                            voice.Instance->Play();
                             //if (!sound.Loop)
-                            sound->Started = true;
+                            voice.Started = true;
                         }
 
-                        sound->UpdateEmitter(Render::Camera.Position, dt);
-                        sound->Instance->Apply3D(Listener, sound->Emitter, false);
-                        sound++;
+                        voice.UpdateEmitter(Render::Camera.Position, dt);
+                        voice.Instance->Apply3D(Listener, voice.Emitter, false);
+                        activeVoices++;
                     }
+
+                    Metrics::ActiveVoices = activeVoices;
                 }
                 catch (const std::exception& e) {
                     SPDLOG_ERROR("Error in audio worker: {}", e.what());
                 }
 
+                {
+                    std::scoped_lock lock(ResetMutex);
+                    FreeRetiredSounds();
+                }
+
                 std::this_thread::sleep_for(pollRate);
             }
             else {
@@ -199,31 +325,78 @@ namespace Inferno::Sound {
         CoUninitialize();
     }
 
-    // Creates a mono PCM sound effect
-    SoundEffect CreateSoundEffect(AudioEngine& engine, span<ubyte> raw, uint32 frequency = 22050, float trimStart = 0) {
+    uint32 GetMixerSampleRate() {
+        auto rate = MixerSampleRate.load();
+        return rate ? rate : 22050;
+    }
+
+    void SetPcmFormat(WAVEFORMATEX& wfx, uint32 sampleRate) {
+        wfx.wFormatTag = WAVE_FORMAT_PCM;
+        wfx.nChannels = 1;
+        wfx.nSamplesPerSec = sampleRate;
+        wfx.nAvgBytesPerSec = sampleRate * sizeof(int16);
+        wfx.nBlockAlign = sizeof(int16);
+        wfx.wBitsPerSample = 16;
+        wfx.cbSize = 0;
+    }
+
+    size_t GetResampledCount(size_t srcCount, uint32 srcRate, uint32 dstRate) {
+        return (size_t)((uint64)srcCount * dstRate / srcRate);
+    }
+
+    // Resamples mono PCM to signed 16-bit at the destination rate using linear interpolation.
+    // Source samples are either unsigned 8-bit or signed 16-bit.
+    void ResamplePcm(span<const ubyte> src, uint16 srcBits, uint32 srcRate, uint32 dstRate, span<int16> dst) {
+        auto srcCount = srcBits == 8 ? src.size() : src.size() / sizeof(int16);
+        if (srcCount == 0) return;
+
+        auto sampleAt = [&](size_t i) {
+            if (srcBits == 8) return (float(src[i]) - 128.0f) * 256.0f;
+            return (float)((const int16*)src.data())[i];
+        };
+
+        auto step = (double)srcRate / dstRate;
+        for (size_t i = 0; i < dst.size(); i++) {
+            auto pos = i * step;
+            auto i0 = std::min((size_t)pos, srcCount - 1);
+            auto i1 = std::min(i0 + 1, srcCount - 1);
+            auto value = std::lerp(sampleAt(i0), sampleAt(i1), float(pos - (double)i0));
+            dst[i] = (int16)std::clamp(value, -32768.0f, 32767.0f);
+        }
+    }
+
+    // Creates a mono PCM sound effect in the mixer format
+    SoundEffect CreateSoundEffect(AudioEngine& engine, span<const ubyte> raw, uint16 bits, uint32 frequency = 22050, float trimStart = 0) {
+        auto blockAlign = bits / 8;
+        auto trim = std::min(size_t(frequency * trimStart) * blockAlign, raw.size());
+        auto src = raw.subspan(trim);
+
+        auto sampleRate = GetMixerSampleRate();
+        auto count = GetResampledCount(src.size() / blockAlign, frequency, sampleRate);
+
         // create a buffer and store wfx at the beginning.
-        int trim = int(frequency * trimStart);
-        auto wavData = MakePtr<uint8[]>(raw.size() + sizeof(WAVEFORMATEX) - trim);
+        auto wavData = MakePtr<uint8[]>(sizeof(WAVEFORMATEX) + count * sizeof(int16));
         auto startAudio = wavData.get() + sizeof(WAVEFORMATEX);
-        memcpy(startAudio, raw.data() + trim, raw.size() - trim);
+        ResamplePcm(src, bits, frequency, sampleRate, span((int16*)startAudio, count));
 
         auto wfx = (WAVEFORMATEX*)wavData.get();
-        wfx->wFormatTag = WAVE_FORMAT_PCM;
-        wfx->nChannels = 1;
-        wfx->nSamplesPerSec = frequency;
-        wfx->nAvgBytesPerSec = frequency;
-        wfx->nBlockAlign = 1;
-        wfx->wBitsPerSample = 8;
-        wfx->cbSize = 0;
+        SetPcmFormat(*wfx, sampleRate);
 
         // Pass the ownership of the buffer to the sound effect
-        return SoundEffect(&engine, wavData, wfx, startAudio, raw.size() - trim);
+        return SoundEffect(&engine, wavData, wfx, startAudio, count * sizeof(int16));
     }
 
     SoundEffect CreateSoundEffectWav(AudioEngine& engine, span<ubyte> raw) {
         DirectX::WAVData result{};
         DirectX::LoadWAVAudioInMemoryEx(raw.data(), raw.size(), result);
 
+        auto wfx = result.wfx;
+        if (wfx->wFormatTag == WAVE_FORMAT_PCM && wfx->nChannels == 1 &&
+            (wfx->wBitsPerSample == 8 || wfx->wBitsPerSample == 16)) {
+            // Convert simple PCM to the mixer format so the voice doesn't need to resample
+            return CreateSoundEffect(engine, span(result.startAudio, result.audioBytes), wfx->wBitsPerSample, wfx->nSamplesPerSec);
+        }
+
         // create a buffer and store wfx at the beginning.
         auto wavData = MakePtr<uint8[]>(result.audioBytes + sizeof(WAVEFORMATEX));
         auto pWavData = wavData.get();
@@ -235,6 +408,29 @@ namespace Inferno::Sound {
         return SoundEffect(&engine, wavData, (WAVEFORMATEX*)wavData.get(), startAudio, result.audioBytes);
     }
 
+    // Creates an effect that plays samples stored in the cache. Returns null if the sound isn't cached.
+    Ptr<SoundEffect> CreateCachedEffect(AudioEngine& engine, size_t id) {
+        std::scoped_lock lock(CacheMutex);
+        auto sound = CachedSounds.find(id);
+        if (sound == CachedSounds.end()) return {};
+
+        // The effect only owns the format header, the samples remain in the arena
+        auto wavData = MakePtr<uint8[]>(sizeof(WAVEFORMATEX));
+        auto wfx = (WAVEFORMATEX*)wavData.get();
+        SetPcmFormat(*wfx, sound->second.SampleRate);
+        auto startAudio = (const uint8*)sound->second.Samples;
+        return MakePtr<SoundEffect>(&engine, wavData, wfx, startAudio, sound->second.Count * sizeof(int16));
+    }
+
+    // Playback frequency of D1 and D2 sounds
+    uint32 GetSoundFrequency(const SoundResource& resource) {
+        if (resource.D1 != -1) return 11025;
+
+        // The Class 1 driller sound was not resampled for D2 and should be a lower frequency
+        if (resource.D2 == 127) return 11025;
+        return 22050;
+    }
+
     void Shutdown() {
         if (!Alive) return;
         Alive = false;
@@ -292,7 +488,11 @@ namespace Inferno::Sound {
         if (SoundsD1[id]) return SoundsD1[int(id)].get();
 
         std::scoped_lock lock(ResetMutex);
-        int frequency = 11025;
+        SoundResource resource{ .D1 = id };
+        if (auto effect = CreateCachedEffect(*Engine, resource.GetID()))
+            return (SoundsD1[id] = std::move(effect)).get();
+
+        auto frequency = GetSoundFrequency(resource);
         float trimStart = 0;
         if (id == 47)
             trimStart = 0.05f; // Trim the first 50ms from the door close sound due to a crackle
@@ -301,7 +501,7 @@ namespace Inferno::Sound {
         if (data.empty()) return nullptr;
         //Sounds[int(id)] = MakePtr<SoundEffect>(CreateSoundEffect(*Engine, data, frequency, trimStart));
         //return Sounds[int(id)].get();
-        return (SoundsD1[int(id)] = MakePtr<SoundEffect>(CreateSoundEffect(*Engine, data, frequency))).get();
+        return (SoundsD1[int(id)] = MakePtr<SoundEffect>(CreateSoundEffect(*Engine, data, 8, frequency))).get();
     }
 
     SoundEffect* LoadSoundD2(int id) {
@@ -309,15 +509,13 @@ namespace Inferno::Sound {
         if (SoundsD2[id]) return SoundsD2[int(id)].get();
 
         std::scoped_lock lock(ResetMutex);
-        int frequency = 22050;
-
-        // The Class 1 driller sound was not resampled for D2 and should be a lower frequency
-        if (id == 127)
-            frequency = 11025;
+        SoundResource resource{ .D2 = id };
+        if (auto effect = CreateCachedEffect(*Engine, resource.GetID()))
+            return (SoundsD2[id] = std::move(effect)).get();
 
         auto data = Resources::SoundsD2.Read(id);
         if (data.empty()) return nullptr;
-        return (SoundsD2[int(id)] = MakePtr<SoundEffect>(CreateSoundEffect(*Engine, data, frequency))).get();
+        return (SoundsD2[int(id)] = MakePtr<SoundEffect>(CreateSoundEffect(*Engine, data, 8, GetSoundFrequency(resource)))).get();
     }
 
     SoundEffect* LoadSoundD3(string fileName) {
@@ -353,25 +551,48 @@ namespace Inferno::Sound {
         auto sfx = LoadSound(sound.Resource);
         if (!sfx) return;
 
-        auto position = sound.Position * AUDIO_SCALE;
+        // Attached sounds follow their source, so cull and rank them from where the source is now
+        auto position = sound.Position;
+        auto segment = sound.Segment;
+        if (auto obj = sound.AttachToSource ? Game::Level.TryGetObject(sound.Source) : nullptr) {
+            position = obj->Position;
+            segment = obj->Segment;
+        }
+
+        position *= AUDIO_SCALE;
+        auto& listener = Render::Camera.Position;
+        auto audibility = GetAudibility(position, listener, sound.Volume);
+
+        if (audibility <= 0) {
+            Metrics::CulledVoices++; // Too far away to be heard
+            return;
+        }
 
         {
-            std::scoped_lock lock(ObjectSoundsMutex);
+            std::scoped_lock lock(VoiceMutex);
+            auto soundId = sound.Resource.GetID();
 
             // Check if any emitters are already playing this sound from this source
             if (sound.Source != ObjID::None) {
-                for (auto& instance : ObjectSounds) {
-                    if (instance.Source == sound.Source &&
-                        instance.Sound == sound.Resource.GetID() &&
-                        instance.StartTime + MERGE_WINDOW > Game::ElapsedTime) {
-                        instance.Emitter.Position = (position + instance.Emitter.Position) / 2;
+                for (auto& voice : Voices) {
+                    if (voice.IsPlaying() &&
+                        voice.Source == sound.Source &&
+                        voice.Sound == soundId &&
+                        voice.StartTime + MERGE_WINDOW > Game::ElapsedTime) {
+                        voice.Emitter.Position = (position + voice.Emitter.Position) / 2;
                         return; // Don't play sounds within the merge window
                     }
                 }
             }
 
-            auto& s = ObjectSounds.emplace_back();
-            s.Instance = sfx->CreateInstance(SoundEffectInstance_Use3D | SoundEffectInstance_ReverbUseFilters);
+            auto voice = FindVoice(sound.Priority, audibility, listener);
+            if (!voice) {
+                Metrics::CulledVoices++;
+                return;
+            }
+
+            auto& s = *voice;
+            s.Instance = AcquireInstance(*sfx, soundId);
             s.Instance->SetVolume(sound.Volume);
             s.Instance->SetPitch(sound.Pitch);
 
@@ -382,22 +603,229 @@ namespace Inferno::Sound {
             //s.Emitter.pCone = (X3DAUDIO_CONE*)&c_emitterCone;
 
             s.StartTime = Game::ElapsedTime;
-            s.Sound = sound.Resource.GetID();
+            s.ID = NextSoundID++;
+            s.Sound = soundId;
+            s.Volume = sound.Volume;
+            s.Priority = sound.Priority;
             s.Source = sound.Source;
-            s.Segment = sound.Segment;
+            s.Segment = segment;
             s.AttachToSource = sound.AttachToSource;
+
+            // Start unoccluded so the volume doesn't jump when the first occlusion result arrives
+            s.HasSource = Game::Level.TryGetObject(sound.Source) != nullptr;
+            s.Muffle = 1;
+        }
+    }
+
+    // Reads and converts D1 and D2 sounds into a single arena
+    void PrecacheSounds(const List<SoundResource>& resources) {
+        struct Entry {
+            size_t ID;
+            SoundResource Resource;
+            List<ubyte> Raw;
+            size_t Offset = 0, Count = 0;
+        };
+
+        auto generation = CacheGeneration.load();
+        List<Entry> entries;
+        List<int> d1, d2;
+
+        {
+            std::scoped_lock lock(CacheMutex);
+            Set<size_t> queued;
+
+            for (auto& resource : resources) {
+                if (!resource.D3.empty()) continue; // D3 sounds are converted on first use
+                auto id = resource.GetID();
+                if (CachedSounds.contains(id) || !queued.insert(id).second) continue;
+
+                auto& file = resource.D1 != -1 ? Resources::SoundsD1 : Resources::SoundsD2;
+                auto index = resource.D1 != -1 ? resource.D1 : resource.D2;
+                if (!Seq::inRange(file.Sounds, index)) continue;
+
+                // Long sounds are rare, don't keep them resident
+                if (file.Sounds[index].Length > GetSoundFrequency(resource) * MAX_PRECACHE_LENGTH) continue;
+
+                (resource.D1 != -1 ? d1 : d2).push_back(index);
+                entries.push_back({ .ID = id, .Resource = resource });
+            }
+        }
+
+        if (entries.empty()) return;
+
+        // Read each file in one pass
+        auto d1Data = Resources::SoundsD1.Read(d1);
+        auto d2Data = Resources::SoundsD2.Read(d2);
+        size_t d1Index = 0, d2Index = 0;
+
+        auto sampleRate = GetMixerSampleRate();
+        size_t total = 0;
+
+        for (auto& entry : entries) {
+            entry.Raw = std::move(entry.Resource.D1 != -1 ? d1Data[d1Index++] : d2Data[d2Index++]);
+            entry.Offset = total;
+            entry.Count = GetResampledCount(entry.Raw.size(), GetSoundFrequency(entry.Resource), sampleRate);
+            total += entry.Count;
+        }
+
+        auto arena = MakePtr<int16[]>(total);
+
+        std::for_each(std::execution::par, entries.begin(), entries.end(), [&](Entry& entry) {
+            ResamplePcm(entry.Raw, 8, GetSoundFrequency(entry.Resource), sampleRate, span(arena.get() + entry.Offset, entry.Count));
+        });
+
+        std::scoped_lock lock(CacheMutex);
+        if (generation != CacheGeneration) {
+            SPDLOG_INFO("Discarding {} sounds cached before a reset", entries.size());
+            return;
+        }
+
+        for (auto& entry : entries) {
+            if (entry.Count == 0) continue;
+            CachedSounds[entry.ID] = { arena.get() + entry.Offset, entry.Count, sampleRate };
+        }
+
+        SPDLOG_INFO("Cached {} sounds ({} KB)", entries.size(), total * sizeof(int16) / 1024);
+        SoundArenas.push_back(std::move(arena));
+    }
+
+    void Precache(List<SoundResource> resources) {
+        if (!Alive) return;
+
+        {
+            // Replace any request that hasn't started, only the latest level matters
+            std::scoped_lock lock(PrecacheMutex);
+            PendingPrecache = std::move(resources);
+            if (Precaching.exchange(true)) return; // The running job picks it up when it finishes
         }
+
+        StartAsync([] {
+            while (true) {
+                List<SoundResource> pending;
+
+                {
+                    std::scoped_lock lock(PrecacheMutex);
+                    if (!PendingPrecache) {
+                        Precaching = false;
+                        return;
+                    }
+
+                    pending = std::move(*PendingPrecache);
+                    PendingPrecache.reset();
+                }
+
+                try {
+                    PrecacheSounds(pending);
+                }
+                catch (const std::exception& e) {
+                    SPDLOG_ERROR("Error caching sounds: {}", e.what());
+                }
+            }
+        });
+    }
+
+    void UpdateOcclusion(Level& level, const Vector3& listener) {
+        if (!Alive) return;
+
+        auto& queries = OcclusionQueries;
+        queries.clear();
+
+        {
+            // Only hold the lock long enough to copy the emitters
+            std::scoped_lock lock(VoiceMutex);
+            for (uint32 i = 0; i < Voices.size(); i++) {
+                auto& sound = Voices[i];
+                if (!sound.IsPlaying()) continue;
+
+                auto& query = queries.emplace_back();
+                query.ID = sound.ID;
+                query.Voice = i;
+                query.Position = sound.Emitter.Position;
+                query.Segment = sound.Segment;
+
+                if (auto obj = level.TryGetObject(sound.Source)) {
+                    query.HasSource = true;
+                    if (sound.AttachToSource) {
+                        query.Position = obj->Position * AUDIO_SCALE;
+                        query.Segment = obj->Segment;
+                    }
+                }
+            }
+        }
+
+        auto castRay = [&level, &listener](EmitterOcclusion& query) {
+            if (!query.HasSource) return;
+
+            auto emitterPos = query.Position / AUDIO_SCALE;
+            auto delta = listener - emitterPos;
+            auto dist = delta.Length();
+            if (dist >= MAX_DISTANCE) return; // only hit test if sound is actually within range
+
+            Vector3 dir;
+            delta.Normalize(dir);
+            Ray ray(emitterPos, dir);
+            LevelHit hit;
+            if (IntersectLevel(level, ray, query.Segment, dist, hit)) {
+                auto hitPoint = emitterPos + dir * hit.Distance;
+                auto hitDist = (listener - hitPoint).Length();
+                // we hit a wall, muffle it based on the distance from the source
+                // a sound coming immediately around the corner shouldn't get muffled much
+                query.Muffle = std::clamp(1 - hitDist / 60, 0.25f, 0.95f);
+            }
+        };
+
+        // The level is only read while the rays are cast, so they can be evaluated in parallel
+        if (queries.size() >= PARALLEL_OCCLUSION_THRESHOLD)
+            std::for_each(std::execution::par, queries.begin(), queries.end(), castRay);
+        else
+            std::for_each(queries.begin(), queries.end(), castRay);
+
+        Debug::Emitters.clear();
+        for (auto& query : queries)
+            Debug::Emitters.push_back(query.Position / AUDIO_SCALE);
+
+        auto& back = Occlusion.Back();
+        back.assign(queries.begin(), queries.end());
+        Occlusion.Publish();
     }
 
     void Reset() {
         std::scoped_lock lock(ResetMutex);
         SPDLOG_INFO("Clearing audio cache");
 
-        //SoundsD1.clear(); // unknown if effects must be stopped before releasing
-        Engine->TrimVoicePool();
+        {
+            // Stop 3D sounds and release their instances before the effects they were created from
+            std::scoped_lock voiceLock(VoiceMutex);
+            for (auto& voice : Voices)
+                ReleaseVoice(voice);
+
+            InstancePool.clear(); // Release idle instances from the previous level
+        }
+
+        // Effects for cached sounds point into the arenas. 2D sounds may still be playing from them,
+        // so both are retired until the mixer thread sees that they stopped.
+        RetiredSounds retired;
+        auto retire = [&retired](Ptr<SoundEffect>& effect) {
+            if (effect) retired.Effects.push_back(std::move(effect));
+        };
+
+        for (auto& sound : SoundsD1) retire(sound);
+        for (auto& sound : SoundsD2) retire(sound);
+        for (auto& sound : SoundsD3 | views::values) retire(sound);
+        SoundsD3.clear();
+
+        {
+            std::scoped_lock cacheLock(CacheMutex);
+            CachedSounds.clear();
+            retired.Arenas = std::move(SoundArenas);
+            SoundArenas.clear();
+            CacheGeneration++;
+        }
+
+        Retired.push_back(std::move(retired));
+        FreeRetiredSounds();
 
-        //for (auto& sound : Sounds)
-        //    sound.release(); // unknown if effects must be stopped before releasing
+        if (Engine) Engine->TrimVoicePool();
     }
 
     void PrintStatistics() {
@@ -420,9 +848,10 @@ namespace Inferno::Sound {
     void Stop3DSounds() {
         if (!Alive) return;
 
-        std::scoped_lock lock(ObjectSoundsMutex);
-        for (auto& sound : ObjectSounds) {
-            sound.Instance->Stop();
+        std::scoped_lock lock(VoiceMutex);
+        for (auto& voice : Voices) {
+            if (voice.IsPlaying())
+                voice.Instance->Stop();
         }
     }
 
@@ -3,6 +3,7 @@
 #include <windef.h>
 #include "Types.h"
 #include "Camera.h"
+#include "Level.h"
 
 namespace Inferno::Sound {
     // Sound source priority: D3, D1, D2
@@ -26,6 +27,11 @@ namespace Inferno::Sound {
         SoundResource Resource;
     };
 
+    // Voice priorities for 3D sounds. Impacts and doors use the default.
+    constexpr uint8 PRIORITY_DEFAULT = 0;
+    constexpr uint8 PRIORITY_CUE = 1; // Feedback to the player, such as shooting a locked door
+    constexpr uint8 PRIORITY_PLAYER_WEAPON = 2;
+
     struct Sound3D {
         Sound3D(ObjID source) : Source(source) { }
         Sound3D(const Vector3& pos, SegID seg) : Position(pos), Segment(seg) {}
@@ -37,6 +43,7 @@ namespace Inferno::Sound {
         float Pitch = 0;
         SoundResource Resource;
         bool AttachToSource = false;
+        uint8 Priority = PRIORITY_DEFAULT; // Higher priority sounds steal voices from lower priority ones
     };
     
     void Init(HWND, float volume = 1, std::chrono::milliseconds pollRate = std::chrono::milliseconds(10));
@@ -44,6 +51,13 @@ namespace Inferno::Sound {
     void Play(const SoundResource& resource, float volume = 1, float pan = 0, float pitch = 0);
     void Play(const Sound3D& sound);
 
+    // Casts occlusion rays for all active emitters against the level and hands the results to the audio thread.
+    // Call once per game tick from the thread that owns the level.
+    void UpdateOcclusion(Level& level, const Vector3& listener);
+
+    // Converts sounds to the mixer format on a background thread so they are ready before they are played
+    void Precache(List<SoundResource> resources);
+
     // Resets any cached sounds after loading a level
     void Reset();
 
@@ -82,4 +96,11 @@ namespace Inferno::Sound {
     namespace Debug {
         inline List<Vector3> Emitters;
     }
+
+    namespace Metrics {
+        inline std::atomic<uint32> ActiveVoices; // 3D voices currently playing
+        inline std::atomic<uint32> CulledVoices; // Sounds discarded due to distance or the voice limit
+        inline std::atomic<uint32> StolenVoices; // Voices stopped early to play a more important sound
+        inline std::atomic<uint32> ReusedInstances; // Sounds played using a pooled instance
+    }
 }
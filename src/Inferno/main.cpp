@@ -181,11 +181,29 @@ void TestSegID() {
     assert(id == SegID(6));
 }
 
-int main() {
+// Relights the levels in a mission without opening the editor: Inferno.exe --relight <mission.hog>
+int RelightMission(const filesystem::path& path) {
+    try {
+        Settings::Load();
+        FileSystem::Init();
+        Resources::Init();
+        Editor::RelightMission(path, Settings::Editor.Lighting);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        fmt::print(stderr, "Unable to relight {}: {}\n", path.string(), e.what());
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
     // https://github.com/gabime/spdlog/wiki/3.-Custom-formatting#pattern-flags
     spdlog::set_pattern("[%M:%S.%e] [%^%l%$] [TID:%t] [%s:%#] %v");
     std::srand((uint)std::time(nullptr)); // seed c-random
 
+    if (argc == 3 && string_view(argv[1]) == "--relight")
+        return RelightMission(argv[2]);
+
     try {
         Shell shell;
         //CoInitializeEx(nullptr, COINIT_MULTITHREADED);